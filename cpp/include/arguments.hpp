@@ -28,18 +28,21 @@ public:
 	unsigned int temp_sparsity_output;
 	bool fulldata;
 	bool stdout;
+	bool solver_stats;
 public:
 	GeneralArguments(const std::string& prefix, const std::string& dir,
 				  unsigned short output_precision,
 				  unsigned int temp_sparsity_output,
 				  bool fulldata,
-				  bool stdout):
+				  bool stdout,
+				  bool solver_stats = false):
 			prefix(prefix),
 			dir(dir),
 			output_precision(output_precision),
 			temp_sparsity_output(temp_sparsity_output),
 			fulldata(fulldata),
-			stdout(stdout) {}
+			stdout(stdout),
+			solver_stats(solver_stats) {}
 };
 
 
@@ -311,6 +314,14 @@ public:
 	constexpr static const unsigned int default_Nt_for_tau = 200;
 	constexpr static const char default_gridscale[] = "log";
 	constexpr static const unsigned short default_starlod = 3;
+	constexpr static const double default_eps = 1e-6;
+	constexpr static const char default_nonlinear_solver[] = "picard";
+	constexpr static const unsigned int default_anderson_depth = 3;
+	constexpr static const double default_tau_rtol = 1e-2;
+	constexpr static const double default_tau_min_to_tau = 1e-3;
+	constexpr static const char default_time_scheme[] = "euler";
+	constexpr static const double default_remesh_refine = 8.;
+	constexpr static const char default_wind_coupling[] = "explicit";
 public:
 	double init_time;
 	double time;
@@ -319,17 +330,41 @@ public:
 	std::string gridscale;
 	unsigned short starlod = 3;
 	double eps;
+	std::string nonlinear_solver;
+	unsigned int anderson_depth;
+	bool adaptive_tau;
+	double tau_rtol;
+	double tau_min;
+	double tau_max;
+	std::string time_scheme;
+	bool remesh;
+	double remesh_refine;
+	bool moving_boundary;
+	bool predictor;
+	std::string wind_coupling;
 public:
 	CalculationArguments(
 			double inittime,
 			double time, std::optional<double> tau,
 			unsigned int Nx, const std::string& gridscale, const unsigned short starlod,
-			double eps=1e-6):
+			double eps=default_eps, const std::string& nonlinear_solver=default_nonlinear_solver,
+			unsigned int anderson_depth=default_anderson_depth,
+			bool adaptive_tau=false, double tau_rtol=default_tau_rtol,
+			std::optional<double> tau_min={}, std::optional<double> tau_max={},
+			const std::string& time_scheme=default_time_scheme,
+			bool remesh=false, double remesh_refine=default_remesh_refine, bool moving_boundary=false,
+			bool predictor=false, const std::string& wind_coupling=default_wind_coupling):
 			init_time(inittime),
 			time(time),
 			tau(tau ? *tau : time / default_Nt_for_tau),
 			Nx(Nx), gridscale(gridscale), starlod(starlod),
-			eps(eps) {}
+			eps(eps), nonlinear_solver(nonlinear_solver), anderson_depth(anderson_depth),
+			adaptive_tau(adaptive_tau), tau_rtol(tau_rtol),
+			tau_min(tau_min ? *tau_min : this->tau * default_tau_min_to_tau),
+			tau_max(tau_max ? *tau_max : this->tau),
+			time_scheme(time_scheme),
+			remesh(remesh), remesh_refine(remesh_refine), moving_boundary(moving_boundary),
+			predictor(predictor), wind_coupling(wind_coupling) {}
 };
 
 
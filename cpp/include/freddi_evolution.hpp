@@ -3,12 +3,14 @@
 
 #include <functional>  // bind, function
 #include <iterator>
+#include <memory>  // unique_ptr
 #include <vector>
 
 #include <boost/optional.hpp>
 
 #include "arguments.hpp"
 #include "freddi_state.hpp"
+#include "nonlinear_diffusion.hpp"
 #include "spectrum.hpp"
 
 
@@ -40,12 +42,70 @@ public:
 };
 
 
+class FreddiEvolutionBatch;
+
+
 class FreddiEvolution: public FreddiState {
+	friend class FreddiEvolutionBatch;
+private:
+	// Viscous torque on the time moment before an accepted step and the size of this step
+	struct PreviousStep {
+		vecd F;
+		size_t first = 0, last = 0;
+		double tau = 0.;
+	};
+private:
+	NonlinearDiffusionSolver diffusion_;
+	// Wind revision used for the cached coefficients of the diffusion solver
+	unsigned int wind_revision_;
+	const bool bdf2_;
+	const bool implicit_wind_;
+	// Adaptive time step controller: proposed size of the next step. State before the current step and two
+	// previous accepted steps are used by BDF2 scheme and to estimate truncation error
+	double tau_next_;
+	CurrentState state_before_step_;
+	PreviousStep prev_, prev2_;
+	// Disk boundaries on the grid built by the last remeshing
+	bool remeshed_ = false;
+	size_t remesh_first_ = 0, remesh_last_ = 0;
+	// Position of the outer boundary of the hot disk between grid points found by truncateOuterRadius, it is used
+	// to move the boundary point after the step is accepted, see --movingboundary
+	boost::optional<double> front_h_;
+	// Initial guess of the non-linear solver, see --predictor
+	vecd F_guess_;
+	// Viscous torque on the beginning of the step and the last trial solution, see --windcoupling
+	vecd F_start_, F_trial_;
+private:
+	static NonlinearDiffusionSolver::Method initializeNonlinearSolverMethod(const std::string& nonlinear_solver);
+	static bool initializeBDF2(const std::string& time_scheme);
+	static bool initializeImplicitWind(const std::string& wind_coupling);
+	void prepareStep(double tau);
+	bool predictGuess(double tau);
+	void diffuse(double tau, bool bdf2, const vecd& F_guess);
+	void solveImplicitWind(double tau, bool bdf2, const vecd& F_guess);
+	unsigned short solveDiffusion(double tau);
+	void finishStep();
+	unsigned short singleStep(double tau);
+	void acceptStep(double tau);
+	void adaptiveStep(double tau);
+	double truncationError(double tau, unsigned short order) const;
+	vecd remeshDensity(const vecd& h, size_t first, size_t last) const;
+	static void equidistribute(const vecd& h, const vecd& density, size_t i_begin, size_t i_end,
+							   vecd& h_new, size_t k_begin, size_t k_end);
+	static vecd interpolate(const vecd& h, const vecd& y, const vecd& h_new);
+	static size_t remapIndex(const vecd& h, const vecd& h_new, size_t i);
+	void setGrid(vecd&& h_new, vecd&& F_new, size_t first_new, size_t last_new);
+	void moveOuterBoundary();
 protected:
+	// Replaces the grid by the one adapted to the current solution with the outer boundary of the hot disk
+	// at h_hot <= h[last], see --remesh
+	virtual void remesh(double h_hot);
 	virtual void truncateOuterRadius();
 	virtual void truncateInnerRadius() {}
 protected:
-	virtual vecd wunction(const vecd& h, const vecd& F, size_t first, size_t last) const;
+	virtual void wunction(const vecd& h, const vecd& F, vecd& W, size_t first, size_t last) const;
+	// Derivative dW/dF, it is used by Newton non-linear solver
+	virtual void dwunction(const vecd& h, const vecd& F, const vecd& W, vecd& dW, size_t first, size_t last) const;
 public:
 	FreddiEvolution(const FreddiArguments& args);
 	explicit FreddiEvolution(const FreddiEvolution&) = default;
@@ -58,4 +118,32 @@ public:
 };
 
 
+// Evolution of many disks with the same grid size made in lockstep. Diffusion equation is solved for all disks
+// at once by BatchNonlinearDiffusionSolver if they have the same boundary indexes, and disk by disk otherwise.
+// Lockstep is used only if all disks have fixed time step, fixed grid, backward Euler scheme, no predictor and
+// explicit wind coupling, Picard iterations are used regardless of nonlinear_solver argument. Otherwise disks are
+// evolved independently
+class FreddiEvolutionBatch {
+private:
+	std::vector<std::unique_ptr<FreddiEvolution>> disks_;
+	const bool lockstep_;
+	BatchNonlinearDiffusionSolver diffusion_;
+	// Arrays of batch layout, see BatchNonlinearDiffusionSolver
+	vecd h_, wunc_coef_, F_, A_, B_, C_;
+	// Arrays of disk parameters
+	vecd tau_, eps_, F_in_, Mdot_out_;
+private:
+	static std::vector<std::unique_ptr<FreddiEvolution>> initializeDisks(const std::vector<FreddiArguments>& args);
+	static bool initializeLockstep(const std::vector<std::unique_ptr<FreddiEvolution>>& disks);
+	void wunction(const vecd& h, const vecd& F, vecd& W, size_t first, size_t last) const;
+	void lockstepDiffusion();
+public:
+	explicit FreddiEvolutionBatch(const std::vector<FreddiArguments>& args);
+	inline size_t size() const { return disks_.size(); }
+	inline FreddiEvolution& operator[](size_t i) { return *disks_[i]; }
+	inline const FreddiEvolution& operator[](size_t i) const { return *disks_[i]; }
+	void step();
+};
+
+
 #endif //FREDDI_FREDDI_EVOLUTION_HPP
@@ -2,11 +2,13 @@
 #define FREDDI_FREDDI_STATE_HPP
 
 #include <functional>  // bind, function
+#include <initializer_list>
 #include <vector>
 
 #include <boost/optional.hpp>
 
 #include <arguments.hpp>
+#include <nonlinear_diffusion.hpp>
 #include <passband.hpp>
 #include <rochelobe.hpp>
 #include <spectrum.hpp>
@@ -16,7 +18,7 @@
 
 class FreddiState {
 protected:
-	typedef std::function<vecd (const vecd&, const vecd&, size_t, size_t)> wunc_t;
+	typedef NonlinearDiffusionSolver::wunc_t wunc_t;
 public:
 	enum DiskIntegrationRegion {
 		HotRegion,
@@ -24,13 +26,19 @@ public:
 	};
 private:
 	class BasicWind {
+	private:
+		unsigned int revision_ = 0;
 	protected:
 		vecd A_, B_, C_;
 	public:
 		explicit BasicWind(const FreddiState&);
 		virtual ~BasicWind() = 0;
 		virtual BasicWind* clone() const = 0;
-		virtual void update(const FreddiState&) {}
+		// Winds with constant coefficients override it with no-op, so revision shows if coefficients could change.
+		// Coefficients of time-dependent winds depend on the disk state through the accretion rate Mdot_in only
+		virtual void update(const FreddiState&, double Mdot_in) { ++revision_; }
+		inline void update(const FreddiState& state) { update(state, state.Mdot_in()); }
+		inline unsigned int revision() const { return revision_; }
 		inline const vecd& A() const { return A_; }
 		inline const vecd& B() const { return B_; }
 		inline const vecd& C() const { return C_; }
@@ -42,6 +50,7 @@ private:
 		~NoWind() override = default;
 		NoWind(const NoWind&) = default;
 		virtual NoWind* clone() const override { return new NoWind(*this); }
+		virtual void update(const FreddiState&, double) override {}
 	};
 
 	class SS73CWind: public BasicWind {
@@ -50,6 +59,7 @@ private:
 		~SS73CWind() override = default;
 		SS73CWind(const SS73CWind&) = default;
 		virtual SS73CWind* clone() const override { return new SS73CWind(*this); }
+		virtual void update(const FreddiState&, double) override {}
 	};
 
 	class Cambier2013Wind: public BasicWind {
@@ -62,6 +72,7 @@ private:
 		~Cambier2013Wind() override = default;
 		Cambier2013Wind(const Cambier2013Wind&) = default;
 		virtual Cambier2013Wind* clone() const override { return new Cambier2013Wind(*this); }
+		virtual void update(const FreddiState&, double) override {}
 	};
 
 	class testAWind: public BasicWind {
@@ -73,6 +84,7 @@ private:
 		~testAWind() override = default;
 		testAWind(const testAWind&) = default;
 		virtual testAWind* clone() const override { return new testAWind(*this); }
+		virtual void update(const FreddiState&, double) override {}
 	};
 
 	class testBWind: public BasicWind {
@@ -84,6 +96,7 @@ private:
 		~testBWind() override = default;
 		testBWind(const testBWind&) = default;
 		virtual testBWind* clone() const override { return new testBWind(*this); }
+		virtual void update(const FreddiState&, double) override {}
 	};
 
 	class testCWind: public BasicWind {
@@ -95,6 +108,7 @@ private:
 		~testCWind() override = default;
 		testCWind(const testCWind&) = default;
 		virtual testCWind* clone() const override { return new testCWind(*this); }
+		virtual void update(const FreddiState&, double) override {}
 	};
 
 	class testCq0Shields1986Wind: public BasicWind {
@@ -107,7 +121,7 @@ private:
 		~testCq0Shields1986Wind() override = default;
 		testCq0Shields1986Wind(const testCq0Shields1986Wind&) = default;
 		virtual testCq0Shields1986Wind* clone() const override { return new testCq0Shields1986Wind(*this); }
-		virtual void update(const FreddiState&) override;
+		virtual void update(const FreddiState&, double) override;
 	};
 	
 	class Janiuk2015Wind: public BasicWind {
@@ -122,7 +136,7 @@ private:
 		~Janiuk2015Wind() override = default;
 		Janiuk2015Wind(const  Janiuk2015Wind&) = default;
 		virtual Janiuk2015Wind* clone() const override { return new Janiuk2015Wind(*this); }
-		virtual void update(const FreddiState&) override;
+		virtual void update(const FreddiState&, double) override;
 	};
 	
 	class Shields1986Wind: public BasicWind {
@@ -138,7 +152,7 @@ private:
 		~Shields1986Wind() override = default;
 		Shields1986Wind(const Shields1986Wind&) = default;
 		virtual Shields1986Wind* clone() const override { return new Shields1986Wind(*this); }
-		virtual void update(const FreddiState&) override;
+		virtual void update(const FreddiState&, double) override;
 	};
 
 	class Woods1996AGNWind: public BasicWind {
@@ -153,7 +167,7 @@ private:
 		~Woods1996AGNWind() override = default;
 		Woods1996AGNWind(const Woods1996AGNWind&) = default;
 		virtual Woods1996AGNWind* clone() const override { return new Woods1996AGNWind(*this); }
-		virtual void update(const FreddiState&) override;
+		virtual void update(const FreddiState&, double) override;
 	};
 
 	class Woods1996ShieldsApproxWind : public BasicWind {
@@ -169,7 +183,7 @@ private:
 		~Woods1996ShieldsApproxWind() override = default;
 		Woods1996ShieldsApproxWind(const Woods1996ShieldsApproxWind&) = default;
 		virtual Woods1996ShieldsApproxWind* clone() const override { return new Woods1996ShieldsApproxWind(*this); }
-		virtual void update(const FreddiState&) override;
+		virtual void update(const FreddiState&, double) override;
 	};
 	
 	class PeriodPaperWind : public BasicWind {
@@ -183,7 +197,7 @@ private:
 		~PeriodPaperWind() override = default;
 		PeriodPaperWind(const PeriodPaperWind&) = default;
 		virtual PeriodPaperWind* clone() const override { return new PeriodPaperWind(*this); }
-		virtual void update(const FreddiState&) override;
+		virtual void update(const FreddiState&, double) override;
 	};
 	
 protected:
@@ -231,24 +245,47 @@ private:
 		OpacityRelated oprel;
 		vecd h;
 		vecd R;
+		// Grid-constant factors of the profiles: W = (F^(1-m)) * wunc_coef, Sigma = W * W_to_Sigma,
+		// W = Sigma * Sigma_to_W, Tph_vis = Tph_vis_coef * (3 F / (8 pi sigma_SB))^(1/4), Q_vis = Qvis_coef * F,
+		// relativistic Q_vis = Qvis_GR_coef * Mdot
+		vecd wunc_coef;
+		vecd W_to_Sigma;
+		vecd Sigma_to_W;
+		vecd Tph_vis_coef;
+		vecd Qvis_coef;
+		vecd Qvis_GR_coef;
 		wunc_t wunc;
 	private:
 		static vecd initialize_h(const FreddiArguments& args, size_t Nx);
 		static vecd initialize_R(const vecd& h, double GM);
+		static vecd initialize_wunc_coef(const vecd& h, const OpacityRelated& oprel);
+		static vecd initialize_grid_factor(const vecd& h, const std::function<double (double)>& f);
 	public:
 		DiskStructure(const FreddiArguments& args, const wunc_t& wunc);
+		DiskStructure(const FreddiArguments& args, const wunc_t& wunc, vecd&& h);
 	};
 
+protected:
 	class CurrentState {
 	public:
 		double Mdot_out;
 		double Mdot_in_prev = -INFINITY;
 		double t;
+		// Size of the last time step
+		double tau;
 		size_t i_t;
 		size_t first;
 		size_t last;
 		vecd F;
 		double F_in;
+		unsigned int nonlinear_iterations = 0;
+		double nonlinear_residual = 0.;
+		unsigned int substeps = 0;
+		// Viscous torque on two previous time moments, sizes of the steps made from them and disk boundaries used
+		// by the last step. They are used to extrapolate the initial guess of the next step, see --predictor
+		vecd F_prev, F_prev2;
+		double tau_prev = 0., tau_prev2 = 0.;
+		size_t first_prev = 0, last_prev = 0;
 		explicit CurrentState(const DiskStructure& str);
 		CurrentState(const CurrentState&) = default;
 		CurrentState& operator=(const CurrentState&) = default;
@@ -257,11 +294,85 @@ private:
 		static vecd initializeF(const DiskStructure& str);
 	};
 
+protected:
+	// Parts of the state which optional structure is calculated from, see invalidate_optional_structure()
+	enum StateChange: unsigned int {
+		ChangedF = 1u << 0,
+		ChangedFirst = 1u << 1,
+		ChangedLast = 1u << 2,
+		ChangedWind = 1u << 3,
+		ChangedGrid = 1u << 4,
+		ChangedAll = ChangedF | ChangedFirst | ChangedLast | ChangedWind | ChangedGrid,
+	};
+private:
+	// Lazily calculated quantities, profiles keep their storage between time steps to avoid reallocation. Every
+	// quantity declares the parts of the state and other quantities it depends on, so a change of the state
+	// invalidates only quantities depending on it directly or through other quantities. Profiles are local, their
+	// value in a cell depends on the state of this cell only, so a move of the outer boundary of the hot disk
+	// invalidates only cells between its old and new positions
 	struct DiskOptionalStructure {
+		// Bits follow the ones of StateChange
+		enum Quantity: unsigned int {
+			Lbol = 1u << 5,
+			WProfile = 1u << 6,
+			SigmaProfile = 1u << 7,
+			TphVisProfile = 1u << 8,
+			TphXProfile = 1u << 9,
+			HeightProfile = 1u << 10,
+			KirrProfile = 1u << 11,
+			QxProfile = 1u << 12,
+			TirrProfile = 1u << 13,
+			TphProfile = 1u << 14,
+			MdiskValue = 1u << 15,
+			LxValue = 1u << 16,
+			MdotWindValue = 1u << 17,
+			FnuHotValues = 1u << 18,
+			FnuColdValues = 1u << 19,
+			IrradiationProfiles = HeightProfile | KirrProfile | QxProfile | TirrProfile | TphVisProfile | TphProfile,
+		};
+		struct Dependency {
+			unsigned int quantity;
+			unsigned int depends_on;
+			bool local;
+		};
+		// Every quantity goes after all quantities it depends on
+		static constexpr Dependency dependencies[] = {
+			{Lbol, ChangedF | ChangedFirst | ChangedGrid, false},
+			{WProfile, ChangedF | ChangedFirst | ChangedLast | ChangedGrid, true},
+			{SigmaProfile, WProfile | ChangedFirst | ChangedGrid, true},
+			{TphVisProfile, ChangedF | ChangedFirst | ChangedLast | ChangedGrid, true},
+			{TphXProfile, ChangedF | ChangedFirst | ChangedLast | ChangedGrid, true},
+			{HeightProfile, ChangedF | ChangedFirst | ChangedLast | ChangedGrid, true},
+			{KirrProfile, HeightProfile | ChangedFirst | ChangedLast | ChangedGrid, true},
+			{QxProfile, KirrProfile | HeightProfile | Lbol | ChangedFirst | ChangedGrid, true},
+			{TirrProfile, QxProfile, true},
+			{TphProfile, TphVisProfile | QxProfile, true},
+			{MdiskValue, SigmaProfile | ChangedFirst | ChangedLast, false},
+			{LxValue, TphXProfile | ChangedFirst | ChangedLast, false},
+			{MdotWindValue, ChangedF | ChangedFirst | ChangedLast | ChangedWind | ChangedGrid, false},
+			{FnuHotValues, TphProfile | ChangedFirst | ChangedLast, false},
+			{FnuColdValues, TirrProfile | ChangedLast, false},
+		};
 		boost::optional<double> Mdisk;
 		boost::optional<double> Lx;
 		boost::optional<double> Mdot_wind;
-		boost::optional<vecd> W, Tph, Qx, Tph_vis, Tph_X, Tirr, Kirr, Sigma, Height;
+		vecd W, Tph, Qx, Tph_vis, Tph_X, Tirr, Kirr, Sigma, Height;
+		// Spectral flux densities of the hot and the cold disk for every --lambda value
+		vecd Fnu_hot, Fnu_cold;
+		// Profiles calculated for the current state, partial ones have to be recalculated in cells from
+		// dirty_first to dirty_last
+		unsigned int valid_profiles = 0;
+		unsigned int partial_profiles = 0;
+		size_t dirty_first = 0, dirty_last = 0;
+		inline bool valid(const unsigned int profiles) const {
+			return (valid_profiles & profiles) == profiles && (partial_profiles & profiles) == 0;
+		}
+		inline void validate(const unsigned int profiles) {
+			valid_profiles |= profiles;
+			partial_profiles &= ~profiles;
+		}
+		void invalidate(unsigned int changed, unsigned int changed_locally = 0);
+		void invalidate_cells(size_t i_begin, size_t i_end);
 	};
 
 protected:
@@ -298,9 +409,18 @@ public:
 	inline const FreddiArguments& args() const { return str_->args; }
 	inline const vecd& h() const { return str_->h; }
 	inline const vecd& R() const { return str_->R; }
+	inline const vecd& wunc_coef() const { return str_->wunc_coef; }
+	inline const vecd& W_to_Sigma() const { return str_->W_to_Sigma; }
+	inline const vecd& Sigma_to_W() const { return str_->Sigma_to_W; }
+	inline const vecd& Tph_vis_coef() const { return str_->Tph_vis_coef; }
+	inline const vecd& Qvis_coef() const { return str_->Qvis_coef; }
+	inline const vecd& Qvis_GR_coef() const { return str_->Qvis_GR_coef; }
 	inline const vecd& lambdas() const { return str_->args.flux->lambdas; }
 	inline Star& star() { return star_; }
 	void replaceArgs(const FreddiArguments& args);  // Danger!
+protected:
+	// Replaces grid keeping the same number of points, F should be given on the new grid
+	void replaceGrid(vecd&& h, vecd&& F, size_t first, size_t last);
 // current_
 public:
 	inline double Mdot_out() const { return current_.Mdot_out; }
@@ -311,6 +431,12 @@ public:
 	inline size_t first() const { return current_.first; }
 	inline size_t last() const { return current_.last; }
 	inline double Mdot_in_prev() const { return current_.Mdot_in_prev; }
+	// Statistics of the non-linear solver on the last time step
+	inline unsigned int nonlinear_iterations() const { return current_.nonlinear_iterations; }
+	inline double nonlinear_residual() const { return current_.nonlinear_residual; }
+	// Number of accepted time steps made by the last call of step(), it is larger than one for adaptive time stepping
+	inline unsigned int substeps() const { return current_.substeps; }
+	inline double tau() const { return current_.tau; }
 protected:
 	inline void set_Mdot_in_prev(double Mdot_in) { current_.Mdot_in_prev = Mdot_in; }
 	inline void set_Mdot_in_prev() { set_Mdot_in_prev(Mdot_in()); }
@@ -323,9 +449,9 @@ public:
 	double phase_opt() const;
 // wind_
 public:
-	virtual vecd windA() const { return wind_->A(); }
-	virtual vecd windB() const { return wind_->B(); }
-	virtual vecd windC() const { return wind_->C(); }
+	virtual const vecd& windA() const { return wind_->A(); }
+	virtual const vecd& windB() const { return wind_->B(); }
+	virtual const vecd& windC() { return wind_->C(); }
 // disk_irr_source_
 protected:
 	static std::shared_ptr<BasicFreddiIrradiationSource> initializeFreddiIrradiationSource(const std::string& angular_dist_type);
@@ -333,7 +459,10 @@ public:
 	inline double angular_dist_disk(const double mu) const { return disk_irr_source_->angular_dist(mu); }
 // opt_str_
 protected:
-	virtual void invalidate_optional_structure();
+	virtual void invalidate_optional_structure(unsigned int changed);
+	// Moves the outer boundary of the hot disk, profiles are recalculated only in the cells between the old and the
+	// new boundary
+	void set_last(size_t last);
 
 	template <DiskIntegrationRegion Region> size_t region_first() const {
 		if constexpr(Region == HotRegion) {
@@ -356,10 +485,10 @@ protected:
 	template <DiskIntegrationRegion Region> double integrate(const vecd& values) const {
 		return disk_radial_trapz(R(), values, region_first<Region>(), region_last<Region>());
 	}
-	template <DiskIntegrationRegion Region> double integrate(const std::function<double (size_t)>& func) const {
+	template <DiskIntegrationRegion Region, typename Func> double integrate(const Func& func) const {
 		return disk_radial_trapz(R(), func, region_first<Region>(), region_last<Region>());
 	}
-	template <DiskIntegrationRegion Region> double integrate(const vecd& x, const std::function<double (size_t)>& func) const {
+	template <DiskIntegrationRegion Region, typename Func> double integrate(const vecd& x, const Func& func) const {
 		return trapz(x, func, region_first<Region>(), region_last<Region>());
 	}
 	template <DiskIntegrationRegion Region> double lazy_integrate(boost::optional<double>& x, const vecd& values) {
@@ -368,7 +497,7 @@ protected:
 		}
 		return *x;
 	}
-	template<DiskIntegrationRegion Region> double lazy_integrate(boost::optional<double> &opt, const vecd& x, const std::function<double (size_t)>& values) {
+	template <DiskIntegrationRegion Region, typename Func> double lazy_integrate(boost::optional<double> &opt, const vecd& x, const Func& values) {
 		if (!opt) {
 			opt = integrate<Region>(x, values);
 		}
@@ -383,10 +512,19 @@ protected:
 		} else {
 			static_assert("Wrong Region template argument");
 		}
-		return integrate<Region>([T, lambda](const size_t i) -> double { return Spectrum::Planck_lambda((*T)[i], lambda); });
+		return I_lambda(*T, lambda, region_first<Region>(), region_last<Region>());
 	}
+	double I_lambda(const vecd& T, double lambda, size_t first, size_t last) const;
 	double lazy_magnitude(boost::optional<double>& m, double lambda, double F0);
-	virtual const vecd& Qx();
+	// Luminosity irradiating the disk times angular distribution of its sources, mu is the cosine of the angle
+	// between the ray and the disk normal
+	virtual std::function<double (double)> irradiating_luminosity() const;
+	// Prepares buffers of invalid profiles and gives the range of cells to be calculated, returns false if all
+	// the profiles are valid
+	bool invalid_cells(unsigned int profiles, std::initializer_list<vecd*> buffers, size_t& i_begin, size_t& i_end);
+	// Fills Height, Kirr, Qx, Tirr, Tph_vis and Tph in one pass over the grid
+	void calculate_irradiation_profiles();
+	const vecd& Qx();
 public:
 	double Lx();
     double Fx();
@@ -406,15 +544,44 @@ public:
 		return I_lambda<Region>(lambda) * m::pow<2>(lambda) / GSL_CONST_CGSM_SPEED_OF_LIGHT * cosiOverD2();
 	}
 	template <DiskIntegrationRegion Region> double flux_region(const EnergyPassband& passband) {
-		const double intens = trapz(
-				passband.lambdas,
-				[this, &passband](const size_t i) -> double {
-					return I_lambda<Region>(passband.lambdas[i]) * passband.transmissions[i];
-				},
-				0,
-				passband.data.size() - 1);
-		return intens * cosiOverD2() / passband.t_dnu;
+		const vecd* T;
+		if constexpr(Region == HotRegion) {
+			T = &Tph();
+		} else if constexpr(Region == ColdRegion) {
+			T = &Tirr();
+		} else {
+			static_assert("Wrong Region template argument");
+		}
+		// Passband integral of Planck function is tabulated, so the integral over wavelength goes first
+		return integrate<Region>([T, &passband](const size_t i) -> double { return passband.bb_nu((*T)[i]); }) * cosiOverD2();
+	}
+	// Spectral flux densities for all --lambda values, calculated once per time step
+	template <DiskIntegrationRegion Region> const vecd& fluxes_region() {
+		unsigned int quantity;
+		vecd* Fnu;
+		const vecd* T;
+		if constexpr(Region == HotRegion) {
+			quantity = DiskOptionalStructure::FnuHotValues;
+			Fnu = &opt_str_.Fnu_hot;
+			T = &Tph();
+		} else if constexpr(Region == ColdRegion) {
+			quantity = DiskOptionalStructure::FnuColdValues;
+			Fnu = &opt_str_.Fnu_cold;
+			T = &Tirr();
+		} else {
+			static_assert("Wrong Region template argument");
+		}
+		if (!opt_str_.valid(quantity)) {
+			Fnu->resize(lambdas().size());
+			for (size_t i = 0; i < lambdas().size(); ++i) {
+				const double I = I_lambda(*T, lambdas()[i], region_first<Region>(), region_last<Region>());
+				(*Fnu)[i] = I * m::pow<2>(lambdas()[i]) / GSL_CONST_CGSM_SPEED_OF_LIGHT * cosiOverD2();
+			}
+			opt_str_.validate(quantity);
+		}
+		return *Fnu;
 	}
+	inline const vecd& fluxes() { return fluxes_region<HotRegion>(); }
 	inline double flux(const double lambda) { return flux_region<HotRegion>(lambda); }
 	inline double flux(const EnergyPassband& passband) { return flux_region<HotRegion>(passband); }
 	double flux_star(double lambda, double phase);
@@ -6,9 +6,14 @@
 #include <csignal>		// sig_atomic_t
 #include <exception>	// std::exception
 #include <functional>	// std::function
+#include <memory>		// std::shared_ptr
+#include <thread>		// std::thread::hardware_concurrency
 #include <vector>
 
 
+class ThreadPool;
+
+
 typedef std::vector<double> vecd;
 
 
@@ -16,19 +21,133 @@ double mean_square_rel(const vecd &A, const vecd &B, size_t first, size_t last);
 double max_dif_rel(const vecd &A, const vecd &B, size_t first, size_t last);
 
 
-void nonlinear_diffusion_nonuniform_wind_1_2 (
-		double tau,
-		double eps, // relative error for w
-		double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
-		double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
-		const vecd &A,
-		const vecd &B,
-		const vecd &C,
-		const std::function<vecd (const vecd &, const vecd &, size_t, size_t)>& wunc, // first argument is array of x_i, second — array of y(x_i,t); return value — array of w(x_i,y_i)
-		const vecd &x, // array with (non)uniform grid
-		vecd &y, // array with initial condition and for results
-		size_t first, size_t last // indexes of front and back elements
-);
+// Solver of \frac{dw}{dt}=\frac{d^2y}{dx^2} + A\frac{dy}{dx} + By + C, y=y(x,t) — ?, w = w (x,y)
+// Object keeps its work arrays between calls, so repeated steps on the same grid don't allocate memory
+// Time derivative is approximated by backward Euler scheme, or by variable-step BDF2 scheme if the solution on
+// the previous time moment is provided
+// Non-linear iterations start from the solution on the current time moment or from the provided initial guess
+// Linear systems of at least parallel_min_size points are solved by partitioned tridiagonal algorithm on several
+// threads, its result differs from the serial one by round-off only
+class NonlinearDiffusionSolver {
+public:
+	// first argument is array of x_i, second — array of y(x_i,t), third — output array of w(x_i,y_i)
+	// to be filled in [first, last] range
+	typedef std::function<void (const vecd&, const vecd&, vecd&, size_t, size_t)> wunc_t;
+	// first argument is array of x_i, second — array of y(x_i,t), third — array of w(x_i,y_i),
+	// fourth — output array of dw/dy(x_i,y_i) to be filled in [first, last] range
+	typedef std::function<void (const vecd&, const vecd&, const vecd&, vecd&, size_t, size_t)> dwunc_t;
+	enum Method {
+		// Fixed-point iterations over K = frac * w / y
+		Picard,
+		// Newton-Raphson iterations, requires dw/dy
+		Newton,
+		// Fixed-point iterations over K with Anderson acceleration
+		Anderson,
+	};
+private:
+	Method method;
+	size_t anderson_depth;
+	vecd W, W_prev, dW, K_0, K_1, frac, a, b, c0, f, rhs, alpha, beta, y_0;
+	// Anderson acceleration: weights, previous residual and previous fixed-point map value,
+	// and ring buffers of their differences
+	vecd weight, r, r_prev, g_prev, normal, gamma;
+	std::vector<vecd> dR, dG;
+	size_t history_size = 0, history_next = 0;
+	// Coefficients a, b, c0 and frac depend on grid, A, B and time step only, they are reused while
+	// the grid, the boundary indexes and the time step are the same and invalidate_coefficients() isn't called
+	const double* coefficients_x = nullptr;
+	size_t coefficients_first = 0, coefficients_last = 0;
+	double coefficients_tau = 0.;
+	unsigned int iterations_ = 0;
+	double residual_ = 0.;
+	// Partitioned sweep: number of threads, the smallest system size to use it, pool created on the first use,
+	// coefficient of the left separator value in the chunk solution, and the reduced system for separator values
+	unsigned int threads_;
+	size_t parallel_min_size_;
+	std::shared_ptr<ThreadPool> pool;
+	vecd zeta;
+	std::vector<size_t> separator_index;
+	vecd start_u, start_v, start_w, reduced_alpha, reduced_beta, separator;
+private:
+	void reserve(size_t size);
+	void sweep(const vecd& d, double left_bounder_cond, double right_bounder_cond, const vecd& x, vecd& y, size_t first, size_t last);
+	void partitioned_sweep(const vecd& d, double left_bounder_cond, double right_bounder_cond, const vecd& x, vecd& y, size_t first, size_t last);
+	void anderson_mix(size_t first, size_t last);
+public:
+	static constexpr size_t default_parallel_min_size = 50000;
+public:
+	explicit NonlinearDiffusionSolver(size_t size = 0, Method method = Picard, size_t anderson_depth = 0,
+			unsigned int threads = std::thread::hardware_concurrency(),
+			size_t parallel_min_size = default_parallel_min_size);
+	inline unsigned int threads() const { return threads_; }
+	// Should be called when A or B arrays are changed
+	inline void invalidate_coefficients() { coefficients_x = nullptr; }
+	// Number of linear solutions made by the last call
+	inline unsigned int iterations() const { return iterations_; }
+	// Relative difference of the last two iterations made by the last call
+	inline double residual() const { return residual_; }
+	void operator()(
+			double tau,
+			double eps, // relative error for w
+			double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
+			double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
+			const vecd &A,
+			const vecd &B,
+			const vecd &C,
+			const wunc_t& wunc,
+			const dwunc_t& dwunc, // used by Newton method only
+			const vecd &x, // array with (non)uniform grid
+			vecd &y, // array with initial condition and for results
+			size_t first, size_t last, // indexes of front and back elements
+			double tau_prev = 0., // previous time step, BDF2 scheme is used if it is positive
+			const vecd &y_prev = vecd(), // array with solution on the previous time moment, used by BDF2 only
+			const vecd &y_guess = vecd() // initial approximation of the solution, y is used if it is empty
+	);
+};
+
+
+// Solver of the same equation for many independent problems with the same grid size and boundary indexes,
+// Picard iterations are made for all problems at once until every problem converges.
+// All arrays have structure-of-arrays layout with the problem (lane) index innermost: value of the problem l at
+// the grid point i is stored at i * lanes + l, so loops over problems are vectorized by compiler
+class BatchNonlinearDiffusionSolver {
+public:
+	// Arguments are the same as for NonlinearDiffusionSolver::wunc_t, arrays have batch layout and [first, last]
+	// range is the range of grid points, output array should be filled for all lanes
+	typedef NonlinearDiffusionSolver::wunc_t wunc_t;
+private:
+	size_t lanes_;
+	vecd W, K_0, K_1, frac, a, b, c0, f, alpha, beta;
+	// Iterations stop independently for every lane, K of converged lane is frozen so the next sweeps don't change it
+	std::vector<unsigned char> active;
+	std::vector<unsigned int> iterations_;
+	vecd residual_;
+private:
+	void reserve(size_t size);
+	void sweep(const vecd& left_bounder_cond, const vecd& right_bounder_cond, const vecd& x, vecd& y, size_t first, size_t last);
+public:
+	explicit BatchNonlinearDiffusionSolver(size_t lanes, size_t size = 0);
+	inline size_t lanes() const { return lanes_; }
+	// Number of linear solutions made by the last call for every lane
+	inline const std::vector<unsigned int>& iterations() const { return iterations_; }
+	// Relative difference of the last two iterations made by the last call for every lane
+	inline const vecd& residual() const { return residual_; }
+	// Arguments are the same as for NonlinearDiffusionSolver, scalar arguments are replaced by arrays of lanes
+	// size, other arrays have batch layout
+	void operator()(
+			const vecd &tau,
+			const vecd &eps,
+			const vecd &left_bounder_cond,
+			const vecd &right_bounder_cond,
+			const vecd &A,
+			const vecd &B,
+			const vecd &C,
+			const wunc_t& wunc,
+			const vecd &x,
+			vecd &y,
+			size_t first, size_t last
+	);
+};
 
 
 #endif // _NONLINEAR_DIFFUSION_HPP
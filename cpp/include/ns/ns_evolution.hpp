@@ -74,8 +74,20 @@ private:
 		double dF_dh_Magn_KR07(const double R, const double GM, FreddiEvolution* evolution) const;
 	};
 
+	// windC keeps its storage between time steps as profiles of DiskOptionalStructure do. Luminosity of the neutron
+	// star depends on the accretion rate, windC depends on the wind and the grid only
 	struct NeutronStarOptionalStructure {
 		boost::optional<double> Lx_ns_rest_frame;
+		vecd windC;
+		bool windC_valid = false;
+		inline void invalidate(const unsigned int changed) {
+			if (changed & (ChangedF | ChangedFirst | ChangedGrid)) {
+				Lx_ns_rest_frame = boost::none;
+			}
+			if (changed & (ChangedWind | ChangedGrid)) {
+				windC_valid = false;
+			}
+		}
 	};
 
 	class BasicNSMdotFraction {
@@ -218,7 +230,7 @@ public:
 	double Lx_ns_rest_frame();
 // angular_dist_ns_
 public:
-	inline double angular_dist_ns(const double mu) { return ns_irr_source_->angular_dist(mu); }
+	inline double angular_dist_ns(const double mu) const { return ns_irr_source_->angular_dist(mu); }
 // fp_
 public:
 	inline double fp(double radius) const { return (*fp_)(*this, radius); }
@@ -239,14 +251,15 @@ public:
 	double F_Magn_KR07(const double R) const;
 	double dF_dh_Magn_KR07(const double R) const;
 protected:
-	virtual void invalidate_optional_structure() override;
+	virtual void invalidate_optional_structure(unsigned int changed) override;
 	virtual void truncateInnerRadius() override;
-	virtual vecd windC() const override;
+	virtual void remesh(double h_hot) override;
+	virtual const vecd& windC() override;
 	virtual IrradiatedStar::sources_t star_irr_sources() override;
+	virtual std::function<double (double)> irradiating_luminosity() const override;
 public:
 	FreddiNeutronStarEvolution(const FreddiNeutronStarArguments& args);
 	explicit FreddiNeutronStarEvolution(const FreddiNeutronStarEvolution&) = default;
-	virtual const vecd& Qx() override;
 	virtual double Lbol_disk() const override;
 public:
 	using iterator = EvolutionIterator<FreddiNeutronStarEvolution>;
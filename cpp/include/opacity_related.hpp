@@ -11,7 +11,33 @@
 #include "gsl_const_cgsm.h"
 
 
+// Compile-time exponents of the opacity laws with power functions specialised for them.
+// one_minus_m_pow(F) = F^(1-m), n_pow(h) = h^n, Height_F_pow(F) and Height_R_pow(R) are factors of
+// OpacityRelated::Height
+struct KramersOpacity {
+	static constexpr double m = 0.3;
+	static constexpr double n = 0.8;
+	static inline double one_minus_m_pow(double F) { return std::pow(F, 1. - m); }
+	static inline double n_pow(double h) { return std::pow(h, n); }
+	static inline double Height_F_pow(double F) { return std::pow(F, 3./20.); }
+	static inline double Height_R_pow(double R) { return std::pow(R/1e10, 1./8. - 3./20./2.); }
+};
+
+struct OPALOpacity {
+	static constexpr double m = 1./3.;
+	static constexpr double n = 1.;
+	static inline double one_minus_m_pow(double F) { return std::cbrt(F * F); }
+	static inline double n_pow(double h) { return h; }
+	static inline double Height_F_pow(double F) { return std::sqrt(std::cbrt(F)); }
+	static inline double Height_R_pow(double) { return 1.; }
+};
+
+
 class OpacityRelated{
+public:
+	enum Kind {Kramers, OPAL};
+private:
+	Kind kind;
 private:
 	void init_Kramers();
 	void init_OPAL();
@@ -34,7 +60,21 @@ public:
 	double a0, a1, a2, k, l;
 
 	double Height(double R, double F) const;
+	template <typename Opacity>
+	inline double Height(Opacity, double R, double F) const {
+		return R * Height_coef * Opacity::Height_F_pow(F) * Opacity::Height_R_pow(R);
+	}
 	double f_F(double xi) const;
+
+	// Calls f(KramersOpacity()) or f(OPALOpacity()), so f can be a generic lambda with loop specialised for
+	// the opacity law
+	template <typename Function>
+	inline decltype(auto) dispatch(Function&& f) const {
+		if (kind == OPAL) {
+			return f(OPALOpacity());
+		}
+		return f(KramersOpacity());
+	}
 };
 
 
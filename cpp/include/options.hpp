@@ -67,6 +67,7 @@ public:
 class CalculationOptions: public CalculationArguments {
 protected:
 	static std::optional<double> tauInitializer(const po::variables_map& vm);
+	static std::optional<double> daysInitializer(const po::variables_map& vm, const std::string& name);
 public:
 	CalculationOptions(const po::variables_map& vm);
 	static po::options_description description();
@@ -21,12 +21,29 @@ public:
 		PassbandPoint(double lambda, double transmission):
 				lambda(lambda), transmission(transmission) {}
 	};
+private:
+	// Blackbody integral tabulated for cubic Hermite interpolation of ln(integral) over ln(T)
+	struct BlackbodyTable {
+		double log_T_min;
+		double log_T_step;
+		vecd log_I;
+		vecd dlog_I_dlog_T;
+	};
+	// Table nodes are doubled until interpolation error in the middle of every interval is less than bb_table_rtol,
+	// direct integration is used outside of the table and for passbands with zero integral
+	static constexpr double bb_table_T_min = 1e3;
+	static constexpr double bb_table_T_max = 1e8;
+	static constexpr double bb_table_rtol = 1e-8;
 private:
 	static std::string nameFromPath(const std::string& filepath);
 	static std::vector<PassbandPoint> dataFromFile(const std::string& filepath, DetectorType detector_type);
 	static vecd lambdasFromData(const std::vector<PassbandPoint> data);
 	static vecd transmissionsFromData(const std::vector<PassbandPoint> data);
 	static std::function<double (size_t)> widthFrequencyIntegrationFunction(const vecd& lambdas, const vecd& transmissions);
+	static double bbIntegral(const vecd& lambdas, const vecd& transmissions, double temp);
+	static double bbIntegralDlogT(const vecd& lambdas, const vecd& transmissions, double temp);
+	static BlackbodyTable bbTableFromData(const vecd& lambdas, const vecd& transmissions);
+	static double interpolateBbTable(const BlackbodyTable& table, double log_T);
 public:
 	const std::string name;
 	const std::vector<PassbandPoint> data;
@@ -34,12 +51,15 @@ public:
 	const vecd transmissions;
 	const double t_dl;
 	const double t_dnu;
+private:
+	const BlackbodyTable bb_table;
 public:
 	EnergyPassband(const std::string& name, const std::vector<PassbandPoint>& data):
 			name(name), data(data),
 			lambdas(lambdasFromData(data)), transmissions(transmissionsFromData(data)),
 			t_dl(trapz(lambdas, transmissions, 0, data.size() - 1)),
-			t_dnu(trapz(lambdas, widthFrequencyIntegrationFunction(lambdas, transmissions), 0, data.size() - 1)) {};
+			t_dnu(trapz(lambdas, widthFrequencyIntegrationFunction(lambdas, transmissions), 0, data.size() - 1)),
+			bb_table(bbTableFromData(lambdas, transmissions)) {};
 	EnergyPassband(const std::string& filepath, DetectorType detector_type):
             EnergyPassband(nameFromPath(filepath), dataFromFile(filepath, detector_type)) {};
 	inline double bb_lambda(double temp) const { return bb_integral(temp) / t_dl; }
@@ -3,7 +3,10 @@
 
 
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <vector>
 
@@ -18,9 +21,56 @@ constexpr const double double_h_c2 = 2. * GSL_CONST_CGSM_PLANCKS_CONSTANT_H * GS
 constexpr const double ch_over_kB = GSL_CONST_CGSM_SPEED_OF_LIGHT * h_over_kB;
 double Planck_nu(double T, double nu);
 double Planck_lambda(double T, double lambda);
+// Planck function over arrays of temperatures or wavelengths, loops are branch-free to be vectorized by compiler.
+// Non-positive and NaN temperatures give zero
+void Planck_lambda(const double* T, size_t n, double lambda, double* out);
+void Planck_lambda(double T, const double* lambdas, size_t n, double* out);
 
-double Planck_nu1_nu2(double T, double nu1, double nu2, double tol=std::sqrt(std::numeric_limits<double>::epsilon()));
+// Exponent without branches and library calls, so it can be vectorized by compiler. Cody-Waite range reduction and
+// Taylor polynomial of degree 13 give relative error below 2 ulp. Results below e^-708 are flushed to zero, results
+// above e^709.78 are infinite
+inline double fast_exp(const double x) {
+	constexpr double log2e = 1.4426950408889634;
+	constexpr double ln2_hi = 6.93147180369123816490e-01;
+	constexpr double ln2_lo = 1.90821492927058770002e-10;
+	// 1.5 * 2^52, the sum with it keeps integer part of a number in the lowest bits of mantissa
+	constexpr double shifter = 6755399441055744.0;
+	constexpr double x_min = -708.;
+	constexpr double x_max = 709.78;
 
+	const double x_clipped = std::min(std::max(x, x_min), x_max);
+	const double t = x_clipped * log2e + shifter;
+	const double n = t - shifter;
+	const double r = (x_clipped - n * ln2_hi) - n * ln2_lo;
+	double p = 1. / 6227020800.;
+	p = p * r + 1. / 479001600.;
+	p = p * r + 1. / 39916800.;
+	p = p * r + 1. / 3628800.;
+	p = p * r + 1. / 362880.;
+	p = p * r + 1. / 40320.;
+	p = p * r + 1. / 5040.;
+	p = p * r + 1. / 720.;
+	p = p * r + 1. / 120.;
+	p = p * r + 1. / 24.;
+	p = p * r + 1. / 6.;
+	p = p * r + 0.5;
+	p = p * r + 1.;
+	p = p * r + 1.;
+	// 2^(n-1) is constructed from bits, its exponent is positive for all n allowed by x_min and x_max
+	std::uint64_t t_bits, shifter_bits;
+	std::memcpy(&t_bits, &t, sizeof(t));
+	std::memcpy(&shifter_bits, &shifter, sizeof(shifter));
+	const std::uint64_t scale_bits = (t_bits - shifter_bits + 1022u) << 52;
+	double scale;
+	std::memcpy(&scale, &scale_bits, sizeof(scale));
+	const double result = 2. * p * scale;
+	return x > x_max ? std::numeric_limits<double>::infinity() : (x < x_min ? 0. : result);
+}
+
+double Planck_nu1_nu2(double T, double nu1, double nu2);
+
+// Viscous flux from one side of the relativistic disk per unit accretion rate, Q_vis = Qvis_GR_coef * Mdot
+double Qvis_GR_coef(double r1, double ak, double Mx);
 double T_GR(double r1, double ak, double Mx, double Mdot);
 } // namespace Spectrum
 
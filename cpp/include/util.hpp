@@ -1,10 +1,14 @@
 #ifndef FREDDI_UTIL_HPP
 #define FREDDI_UTIL_HPP
 
+#include <cmath>
+#include <condition_variable>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <valarray>
 #include <vector>
 
@@ -18,13 +22,78 @@ typedef std::valarray<double> vald;
 typedef std::vector<double> vecd;
 typedef std::map<std::string, double> pard;
 
+// Integrands are given either by values or by any callable of cell index, the latter is a template to be inlined
+// into the quadrature loop
 double trapz(const vecd& x, const vecd& y, size_t first, size_t last);
-double trapz(const vecd& x, const std::function<double (size_t)>& f, size_t first, size_t last);
+template <typename Func> double trapz(const vecd& x, const Func& f, size_t first, size_t last) {
+	if (first >= last) {
+		return 0.;
+	}
+	double s = f(first) * (x[first + 1] - x[first]) + f(last) * (x[last] - x[last - 1]);
+	for (size_t i = first + 1; i <= last - 1; i++) {
+		s += f(i) * (x[i + 1] - x[i - 1]);
+	}
+	return 0.5 * s;
+}
 
 double disk_radial_trapz(const vecd& r, const vecd& y, size_t first, size_t last);
-double disk_radial_trapz(const vecd& r, const std::function<double (size_t)>& f, size_t first, size_t last);
+template <typename Func> double disk_radial_trapz(const vecd& r, const Func& f, size_t first, size_t last) {
+	return trapz(r, [&r, &f](const size_t i) -> double { return 2*M_PI * r[i] * f(i); }, first, last);
+}
 
 double simps(const vecd& x, const vecd& y, size_t first, size_t last);
-double simps(const vecd& x, const std::function<double (size_t)>& f, size_t first, size_t last);
+template <typename Func> double simps(const vecd& x, const Func& f, size_t first, size_t last) {
+	const size_t N = last - first + 1;
+	switch (N) {
+		case 0:
+			return 0;
+		case 1:
+			return 0;
+		case 2:
+			return 0.5 * (f(first) + f(last)) * (x[last] - x[first]);
+	}
+	if (N % static_cast<size_t>(2) == static_cast<size_t>(0)) {
+		return simps(x, f, first + 1, last) + simps(x, f, first, first + 1);
+	}
+
+	double delta = (x[first+2] - x[first]);
+	double s = f(first) * delta * (2. - (x[first+2] - x[first+1]) / (x[first+1] - x[first]))
+			   + f(first+1) * m::pow<3>(delta) / ((x[first+2] - x[first+1]) * (x[first+1] - x[first]))
+			   + f(last) * (2. - (x[last-1] - x[last]) / (x[last] - x[last] - 1));
+	for (size_t i = first + 2; i <= last - 2; i += 2) {
+		delta = x[i+2] - x[i];
+		s += f(i) * (delta * (2. - (x[i+2] - x[i+1]) / (x[i+1] - x[i]))
+					 + (x[i] - x[i-2]) * (2. - (x[i-1] - x[i-2]) / (x[i] - x[i-1])))
+			 + f(i+1) * m::pow<3>(delta) / ((x[i+2] - x[i+1]) * (x[i+1] - x[i]));
+	}
+	s /= 6.;
+	return s;
+}
+
+// Fixed set of worker threads running the same function for a range of task indexes.
+// The calling thread runs tasks too, so the pool of n threads has n - 1 workers
+class ThreadPool {
+private:
+	std::vector<std::thread> workers_;
+	// Serializes calls of run() made by different threads
+	std::mutex run_mutex_;
+	std::mutex mutex_;
+	std::condition_variable start_, finish_;
+	const std::function<void (size_t)>* task_ = nullptr;
+	size_t n_tasks_ = 0, next_task_ = 0, pending_ = 0;
+	unsigned long generation_ = 0;
+	bool stop_ = false;
+private:
+	void work();
+	void process(std::unique_lock<std::mutex>& lock);
+public:
+	explicit ThreadPool(unsigned int threads);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	inline unsigned int threads() const { return workers_.size() + 1; }
+	// Calls task(i) for every i in [0, n_tasks) and waits until all of them are finished
+	void run(size_t n_tasks, const std::function<void (size_t)>& task);
+};
 
 #endif //FREDDI_UTIL_HPP
@@ -80,11 +80,20 @@ boost::shared_ptr<CalculationArguments> make_calculation_arguments(
 		double inittime,
 		double time, const object& tau,
 		unsigned int Nx, const std::string& gridscale, const unsigned short starlod,
-		const object& eps) {
+		const object& eps, const std::string& nonlinear_solver, unsigned int anderson_depth,
+		bool adaptive_tau, double tau_rtol, const object& tau_min, const object& tau_max,
+		const std::string& time_scheme, bool remesh, double remesh_refine, bool moving_boundary,
+		bool predictor, const std::string& wind_coupling) {
 	if (eps.ptr() == object().ptr()) {
-		return boost::make_shared<CalculationArguments>(inittime, time, objToOpt<double>(tau), Nx, gridscale, starlod);
+		return boost::make_shared<CalculationArguments>(inittime, time, objToOpt<double>(tau), Nx, gridscale, starlod,
+				CalculationArguments::default_eps, nonlinear_solver, anderson_depth,
+				adaptive_tau, tau_rtol, objToOpt<double>(tau_min), objToOpt<double>(tau_max), time_scheme,
+				remesh, remesh_refine, moving_boundary, predictor, wind_coupling);
 	}
-	return boost::make_shared<CalculationArguments>(inittime, time, objToOpt<double>(tau), Nx, gridscale, starlod, extract<double>(eps));
+	return boost::make_shared<CalculationArguments>(inittime, time, objToOpt<double>(tau), Nx, gridscale, starlod,
+			extract<double>(eps), nonlinear_solver, anderson_depth,
+			adaptive_tau, tau_rtol, objToOpt<double>(tau_min), objToOpt<double>(tau_max), time_scheme,
+			remesh, remesh_refine, moving_boundary, predictor, wind_coupling);
 }
 
 boost::shared_ptr<FreddiArguments> make_freddi_arguments(
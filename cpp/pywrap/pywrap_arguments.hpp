@@ -48,7 +48,10 @@ boost::shared_ptr<CalculationArguments> make_calculation_arguments(
 		double inittime,
 		double time, const object& tau,
 		unsigned int Nx, const std::string& gridscale, unsigned short starlod,
-		const object& eps);
+		const object& eps, const std::string& nonlinear_solver, unsigned int anderson_depth,
+		bool adaptive_tau, double tau_rtol, const object& tau_min, const object& tau_max,
+		const std::string& time_scheme, bool remesh, double remesh_refine, bool moving_boundary,
+		bool predictor, const std::string& wind_coupling);
 
 boost::shared_ptr<FreddiArguments> make_freddi_arguments(
 		const GeneralArguments& general,
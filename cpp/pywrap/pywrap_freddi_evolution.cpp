@@ -78,6 +78,18 @@ dict evolution_kwdefaults() {
 	kw["gridscale"] = CalculationArguments::default_gridscale;
 	kw["starlod"] = CalculationArguments::default_starlod;
 	kw["eps"] = object();
+	kw["nonlinearsolver"] = CalculationArguments::default_nonlinear_solver;
+	kw["andersondepth"] = CalculationArguments::default_anderson_depth;
+	kw["adaptivetau"] = false;
+	kw["taurtol"] = CalculationArguments::default_tau_rtol;
+	kw["taumin"] = object();
+	kw["taumax"] = object();
+	kw["timescheme"] = CalculationArguments::default_time_scheme;
+	kw["remesh"] = false;
+	kw["remeshrefine"] = CalculationArguments::default_remesh_refine;
+	kw["movingboundary"] = false;
+	kw["predictor"] = false;
+	kw["windcoupling"] = CalculationArguments::default_wind_coupling;
 
 	return kw;
 }
@@ -127,6 +139,12 @@ void update_no_cgs_kwargs(dict& kw) {
 	if (object(kw["tau"]).ptr() != None) {
 		kw["tau"] = dayToS(extract<double>(kw["tau"]));
 	}
+	if (object(kw["taumin"]).ptr() != None) {
+		kw["taumin"] = dayToS(extract<double>(kw["taumin"]));
+	}
+	if (object(kw["taumax"]).ptr() != None) {
+		kw["taumax"] = dayToS(extract<double>(kw["taumax"]));
+	}
 }
 
 
@@ -167,7 +185,13 @@ boost::shared_ptr<FreddiArguments> make_freddi_arguments(dict& kw) {
 			extract<double>(kw["time"]), kw["tau"],
 			extract<unsigned int>(kw["Nx"]), extract<std::string>(kw["gridscale"]),
 			extract<unsigned short>(kw["starlod"]),
-			kw["eps"]);
+			kw["eps"], extract<std::string>(kw["nonlinearsolver"]),
+			extract<unsigned int>(kw["andersondepth"]),
+			extract<bool>(kw["adaptivetau"]), extract<double>(kw["taurtol"]), kw["taumin"], kw["taumax"],
+			extract<std::string>(kw["timescheme"]),
+			extract<bool>(kw["remesh"]), extract<double>(kw["remeshrefine"]),
+			extract<bool>(kw["movingboundary"]), extract<bool>(kw["predictor"]),
+			extract<std::string>(kw["windcoupling"]));
 	// To avoid copy, create FreddiArguments constructor that accepts shared_ptr
 	return make_freddi_arguments(*general, *basic, *disk, *irr, *flux, *calc);
 }
@@ -274,7 +298,13 @@ boost::shared_ptr<FreddiNeutronStarArguments> make_freddi_neutron_star_arguments
 			extract<double>(kw["time"]), kw["tau"],
 			extract<unsigned int>(kw["Nx"]), extract<std::string>(kw["gridscale"]),
 			extract<unsigned short>(kw["starlod"]),
-			kw["eps"]);
+			kw["eps"], extract<std::string>(kw["nonlinearsolver"]),
+			extract<unsigned int>(kw["andersondepth"]),
+			extract<bool>(kw["adaptivetau"]), extract<double>(kw["taurtol"]), kw["taumin"], kw["taumax"],
+			extract<std::string>(kw["timescheme"]),
+			extract<bool>(kw["remesh"]), extract<double>(kw["remeshrefine"]),
+			extract<bool>(kw["movingboundary"]), extract<bool>(kw["predictor"]),
+			extract<std::string>(kw["windcoupling"]));
 	return make_freddi_neutron_star_arguments(*general, *basic, *disk, *irr, *flux, *calc, *ns_args);
 }
 
@@ -30,6 +30,10 @@ void wrap_state() {
 		.add_property("Nx", &FreddiState::Nx)
 		.add_property("first", &FreddiState::first)
 		.add_property("last", &FreddiState::last)
+		.add_property("nonlinear_iterations", &FreddiState::nonlinear_iterations)
+		.add_property("nonlinear_residual", &FreddiState::nonlinear_residual)
+		.add_property("substeps", &FreddiState::substeps)
+		.add_property("tau", &FreddiState::tau)
 		.add_property("Mdisk", &FreddiState::Mdisk)
 		.add_property("Mdot_wind", &FreddiState::Mdot_wind)
 		.add_property("h", make_function(&FreddiState::h, return_value_policy<copy_const_reference>()))
@@ -42,9 +46,9 @@ void wrap_state() {
 		.add_property("Kirr", make_function(&FreddiState::Kirr, return_value_policy<copy_const_reference>()))
 		.add_property("Sigma", make_function(&FreddiState::Sigma, return_value_policy<copy_const_reference>()))
 		.add_property("Height", make_function(&FreddiState::Height, return_value_policy<copy_const_reference>()))
-		.add_property("windA", make_function(&FreddiState::windA))
-		.add_property("windB", make_function(&FreddiState::windB))
-		.add_property("windC", make_function(&FreddiState::windC))
+		.add_property("windA", make_function(&FreddiState::windA, return_value_policy<copy_const_reference>()))
+		.add_property("windB", make_function(&FreddiState::windB, return_value_policy<copy_const_reference>()))
+		.add_property("windC", make_function(&FreddiState::windC, return_value_policy<copy_const_reference>()))
 		.add_property("lambdas", make_function(&FreddiState::lambdas, return_value_policy<copy_const_reference>()))
 		.def("_flux_hot", flux_hot)
 		.def("_flux_cold", flux_cold)
@@ -372,3 +372,11 @@ constexpr const unsigned int CalculationArguments::default_Nx;
 constexpr const unsigned int CalculationArguments::default_Nt_for_tau;
 constexpr const char CalculationArguments::default_gridscale[];
 constexpr const unsigned short CalculationArguments::default_starlod;
+constexpr const double CalculationArguments::default_eps;
+constexpr const char CalculationArguments::default_nonlinear_solver[];
+constexpr const unsigned int CalculationArguments::default_anderson_depth;
+constexpr const double CalculationArguments::default_tau_rtol;
+constexpr const double CalculationArguments::default_tau_min_to_tau;
+constexpr const char CalculationArguments::default_time_scheme[];
+constexpr const double CalculationArguments::default_remesh_refine;
+constexpr const char CalculationArguments::default_wind_coupling[];
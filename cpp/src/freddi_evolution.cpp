@@ -1,35 +1,530 @@
 #include "freddi_evolution.hpp"
 
+#include <algorithm>  // lower_bound, max, max_element, min, swap
 #include <cmath>
 #include <string>
 
 #include "arguments.hpp"
 #include "exceptions.hpp"
 #include "nonlinear_diffusion.hpp"
+#include "util.hpp"
 
 using namespace std::placeholders;
 
 
 FreddiEvolution::FreddiEvolution(const FreddiArguments &args):
-		FreddiState(args, std::bind(&FreddiEvolution::wunction, this, _1, _2, _3, _4)) {}
+		FreddiState(args, std::bind(&FreddiEvolution::wunction, this, _1, _2, _3, _4, _5)),
+		diffusion_(Nx(), initializeNonlinearSolverMethod(args.calc->nonlinear_solver), args.calc->anderson_depth),
+		wind_revision_(wind_->revision()),
+		bdf2_(initializeBDF2(args.calc->time_scheme)),
+		implicit_wind_(initializeImplicitWind(args.calc->wind_coupling)),
+		tau_next_(args.calc->tau_min),
+		state_before_step_(current_) {}
+
+
+NonlinearDiffusionSolver::Method FreddiEvolution::initializeNonlinearSolverMethod(const std::string& nonlinear_solver) {
+	if (nonlinear_solver == "picard") {
+		return NonlinearDiffusionSolver::Picard;
+	}
+	if (nonlinear_solver == "newton") {
+		return NonlinearDiffusionSolver::Newton;
+	}
+	if (nonlinear_solver == "anderson") {
+		return NonlinearDiffusionSolver::Anderson;
+	}
+	throw std::invalid_argument("Wrong nonlinearsolver");
+}
+
+
+bool FreddiEvolution::initializeBDF2(const std::string& time_scheme) {
+	if (time_scheme == "euler") {
+		return false;
+	}
+	if (time_scheme == "bdf2") {
+		return true;
+	}
+	throw std::invalid_argument("Wrong timescheme");
+}
+
+
+bool FreddiEvolution::initializeImplicitWind(const std::string& wind_coupling) {
+	if (wind_coupling == "explicit") {
+		return false;
+	}
+	if (wind_coupling == "implicit") {
+		return true;
+	}
+	throw std::invalid_argument("Wrong windcoupling");
+}
 
 
 void FreddiEvolution::step(const double tau) {
+	if (args().calc->remesh && (!remeshed_ || first() != remesh_first_ || last() != remesh_last_)) {
+		remesh(h()[last()]);
+	}
+	if (args().calc->adaptive_tau) {
+		adaptiveStep(tau);
+	} else if (bdf2_) {
+		state_before_step_ = current_;
+		singleStep(tau);
+		acceptStep(tau);
+		moveOuterBoundary();
+		current_.substeps = 1;
+	} else {
+		singleStep(tau);
+		moveOuterBoundary();
+		current_.substeps = 1;
+	}
+}
+
+
+// Changes time and disk boundaries before the diffusion equation is solved
+void FreddiEvolution::prepareStep(const double tau) {
 	truncateInnerRadius();
 	FreddiState::step(tau);
-	nonlinear_diffusion_nonuniform_wind_1_2(
-			args().calc->tau, args().calc->eps,
+	if (wind_->revision() != wind_revision_) {
+		diffusion_.invalidate_coefficients();
+		wind_revision_ = wind_->revision();
+	}
+}
+
+
+// Extrapolates the viscous torque to the end of the step and returns false if the previous step isn't known or was
+// made with other disk boundaries. Extrapolation is quadratic if two previous steps were made with the same
+// boundaries and linear otherwise, extrapolated non-positive values are replaced by the current ones
+bool FreddiEvolution::predictGuess(const double tau) {
+	if (!(current_.tau_prev > 0.) || current_.first_prev != first() || current_.last_prev != last()) {
+		return false;
+	}
+	F_guess_.resize(Nx());
+	const double factor = tau / current_.tau_prev;
+	const bool quad = current_.tau_prev2 > 0.;
+	for (size_t i = first(); i <= last(); ++i) {
+		double F_extrapolated = F()[i] + (F()[i] - current_.F_prev[i]) * factor;
+		if (quad) {
+			const double d_1 = (F()[i] - current_.F_prev[i]) / current_.tau_prev;
+			const double d_2 = (current_.F_prev[i] - current_.F_prev2[i]) / current_.tau_prev2;
+			F_extrapolated += (d_1 - d_2) / (current_.tau_prev + current_.tau_prev2) * tau * (tau + current_.tau_prev);
+		}
+		F_guess_[i] = F_extrapolated > 0. ? F_extrapolated : F()[i];
+	}
+	return true;
+}
+
+
+// Solves the diffusion equation and returns order of the used time scheme. BDF2 needs the viscous torque on
+// the previous time moment, so backward Euler is used for the first step and when the previous step doesn't
+// cover the current disk
+unsigned short FreddiEvolution::solveDiffusion(const double tau) {
+	const bool bdf2 = bdf2_ && prev_.tau > 0. && prev_.first <= first() && prev_.last >= last();
+	const bool predictor = args().calc->predictor && predictGuess(tau);
+	if (args().calc->predictor) {
+		std::swap(current_.F_prev, current_.F_prev2);
+		current_.tau_prev2 = predictor ? current_.tau_prev : 0.;
+		current_.F_prev = current_.F;
+		current_.tau_prev = tau;
+		current_.first_prev = first();
+		current_.last_prev = last();
+	}
+	if (implicit_wind_) {
+		solveImplicitWind(tau, bdf2, predictor ? F_guess_ : vecd());
+	} else {
+		diffuse(tau, bdf2, predictor ? F_guess_ : vecd());
+	}
+	return bdf2 ? 2 : 1;
+}
+
+
+// Solves the diffusion equation with the current wind coefficients
+void FreddiEvolution::diffuse(const double tau, const bool bdf2, const vecd& F_guess) {
+	diffusion_(
+			tau, args().calc->eps,
 			F_in(), Mdot_out(),
 			windA(), windB(), windC(),
 			wunc(),
+			[this](const vecd& h, const vecd& F, const vecd& W, vecd& dW, size_t first, size_t last) {
+				dwunction(h, F, W, dW, first, last);
+			},
 			h(), current_.F,
-			first(), last());
+			first(), last(),
+			bdf2 ? prev_.tau : 0., prev_.F,
+			F_guess);
+	current_.nonlinear_iterations = diffusion_.iterations();
+	current_.nonlinear_residual = diffusion_.residual();
+}
+
+
+// Trial accretion rate is allowed to differ from the previous one not more than twice: the step with much stronger
+// wind than the solution has can be non-physical and the non-linear solver can fail to converge for it
+static double limitWindMdot(const double Mdot, const double Mdot_prev) {
+	return std::min(2. * std::abs(Mdot_prev), std::max(0.5 * std::abs(Mdot_prev), Mdot));
+}
+
+
+// Wind coefficients depend on the accretion rate only, so the implicit coupling is the scalar equation
+// Mdot_in(F(Mdot)) = Mdot, where F(Mdot) is the solution of the step for the wind calculated for Mdot. It is solved
+// by the secant method starting from the accretion rate on the beginning of the step, which gives the explicit
+// step, and its fixed-point iteration. Every trial solution starts from the viscous torque on the beginning of the
+// step with the previous trial solution as the initial guess
+void FreddiEvolution::solveImplicitWind(const double tau, const bool bdf2, const vecd& F_guess) {
+	constexpr unsigned int max_iterations = 100;
+	F_start_ = current_.F;
+	// Wind is calculated for the accretion rate on the beginning of the step by FreddiState::step
+	double Mdot_prev = Mdot_in();
+	diffuse(tau, bdf2, F_guess);
+	unsigned int nonlinear_iterations = current_.nonlinear_iterations;
+	double Mdot_in_prev = Mdot_in();
+	double residual_prev = Mdot_in_prev - Mdot_prev;
+	double Mdot = limitWindMdot(Mdot_in_prev, Mdot_prev);
+	for (unsigned int i = 0; i < max_iterations && std::abs(residual_prev) > args().calc->eps * std::abs(Mdot_in()); ++i) {
+		const unsigned int revision = wind_->revision();
+		wind_->update(*this, Mdot);
+		// Wind with constant coefficients
+		if (wind_->revision() == revision) {
+			break;
+		}
+		diffusion_.invalidate_coefficients();
+		wind_revision_ = wind_->revision();
+		invalidate_optional_structure(ChangedF | ChangedWind);
+		F_trial_ = current_.F;
+		current_.F = F_start_;
+		diffuse(tau, bdf2, F_trial_);
+		nonlinear_iterations += current_.nonlinear_iterations;
+		const double residual = Mdot_in() - Mdot;
+		double Mdot_next = Mdot_in();
+		// Solution doesn't feel the change of the wind, fixed-point iteration converges in one step
+		if (std::abs(Mdot_in() - Mdot_in_prev) > args().calc->eps * std::abs(Mdot_in())) {
+			if (residual != residual_prev) {
+				Mdot_next = Mdot - residual * (Mdot - Mdot_prev) / (residual - residual_prev);
+			}
+			Mdot_next = limitWindMdot(Mdot_next, Mdot);
+		}
+		Mdot_prev = Mdot;
+		Mdot_in_prev = Mdot_in();
+		residual_prev = residual;
+		Mdot = Mdot_next;
+	}
+	current_.nonlinear_iterations = nonlinear_iterations;
+}
+
+
+// Updates disk boundaries and irradiation of the star after the viscous torque is found
+void FreddiEvolution::finishStep() {
 	truncateOuterRadius();
 	star_.set_sources(star_irr_sources());
 }
 
 
+// Makes one step of the diffusion equation solution and returns order of the used time scheme
+unsigned short FreddiEvolution::singleStep(const double tau) {
+	prepareStep(tau);
+	const unsigned short order = solveDiffusion(tau);
+	finishStep();
+	return order;
+}
+
+
+void FreddiEvolution::acceptStep(const double tau) {
+	std::swap(prev_, prev2_);
+	prev_.F = state_before_step_.F;
+	prev_.first = state_before_step_.first;
+	prev_.last = state_before_step_.last;
+	prev_.tau = tau;
+}
+
+
+// Local truncation error of the step relative to the tolerance. The solution is compared with the polynomial
+// extrapolation of previous time moments: linear for backward Euler and quadratic for BDF2. For smooth solution
+// their difference is (tau_eff + tau + tau_prev [+ tau_prev2]) / tau_eff times larger than the truncation error,
+// where tau_eff is tau for backward Euler and tau (1 + omega) / (1 + 2 omega), omega = tau / tau_prev, for BDF2
+double FreddiEvolution::truncationError(const double tau, const unsigned short order) const {
+	const auto& F_0 = state_before_step_.F;
+	const auto& F_1 = prev_.F;
+	const auto& F_2 = prev2_.F;
+	const double tau_1 = prev_.tau;
+	const double tau_2 = prev2_.tau;
+	double tau_eff = tau;
+	double interval = tau + tau_1;
+	size_t i_first = std::max({first(), state_before_step_.first, prev_.first}) + 1;
+	size_t i_last = std::min({last(), state_before_step_.last, prev_.last});
+	if (order == 2) {
+		const double omega = tau / tau_1;
+		tau_eff = tau * (1. + omega) / (1. + 2. * omega);
+		interval += tau_2;
+		i_first = std::max(i_first, prev2_.first + 1);
+		i_last = std::min(i_last, prev2_.last);
+	}
+	double error = 0.;
+	for (size_t i = i_first; i <= i_last; ++i) {
+		if (F()[i] == 0.) {
+			continue;
+		}
+		const double d_1 = (F_0[i] - F_1[i]) / tau_1;
+		double F_extrapolated = F_0[i] + d_1 * tau;
+		if (order == 2) {
+			const double d_2 = (F_1[i] - F_2[i]) / tau_2;
+			F_extrapolated += (d_1 - d_2) / (tau_1 + tau_2) * tau * (tau + tau_1);
+		}
+		const double x = std::abs((F()[i] - F_extrapolated) / F()[i]) * tau_eff / (tau_eff + interval);
+		if (x > error) {
+			error = x;
+		}
+	}
+	return error / args().calc->tau_rtol;
+}
+
+
+// Makes as many steps as required to reach t + tau keeping truncation error below tolerance, the last step is
+// clamped to finish exactly at t + tau
+void FreddiEvolution::adaptiveStep(const double tau) {
+	const double tau_min = args().calc->tau_min;
+	const double tau_max = args().calc->tau_max;
+	const double t_end = t() + tau;
+	const size_t i_t_end = i_t() + 1;
+	unsigned int substeps = 0;
+	unsigned int nonlinear_iterations = 0;
+	double nonlinear_residual = 0.;
+
+	while (t_end - t() > 1e-9 * tau) {
+		const double t_left = t_end - t();
+		double dt = std::min(tau_next_, t_left);
+		// Avoid tiny step at the end of the interval
+		if (dt < t_left && dt > 0.5 * t_left) {
+			dt = 0.5 * t_left;
+		}
+		state_before_step_ = current_;
+		unsigned short order = singleStep(dt);
+		nonlinear_iterations += current_.nonlinear_iterations;
+		nonlinear_residual = std::max(nonlinear_residual, current_.nonlinear_residual);
+
+		double factor = 2.;
+		if (prev_.tau > 0.) {
+			// Quadratic extrapolation needs one more time moment, use overestimated error of the first order
+			if (order == 2 && !(prev2_.tau > 0.)) {
+				order = 1;
+			}
+			const double error = truncationError(dt, order);
+			if (error > 0.) {
+				factor = std::min(factor, 0.9 * std::pow(error, -1. / (order + 1.)));
+			}
+			if (error > 1. && dt > tau_min) {
+				current_ = state_before_step_;
+				invalidate_optional_structure(ChangedF | ChangedFirst | ChangedLast);
+				tau_next_ = std::max(tau_min, dt * std::max(0.2, factor));
+				continue;
+			}
+		}
+		substeps++;
+		acceptStep(dt);
+		moveOuterBoundary();
+		// Step could be clamped by the end of the interval, don't let it decrease the next step
+		tau_next_ = std::min(tau_max, std::max(tau_min, dt < tau_next_ ? std::max(tau_next_, dt * factor) : dt * factor));
+	}
+
+	current_.t = t_end;
+	current_.i_t = i_t_end;
+	current_.substeps = substeps;
+	current_.nonlinear_iterations = nonlinear_iterations;
+	current_.nonlinear_residual = nonlinear_residual;
+}
+
+
+// Density of grid points per unit of h which is equidistributed by remeshing. It is the density of the initial grid
+// multiplied by 1 + remesh_refine * exp(-distance / width) in the hot disk, where distance is measured from
+// the outer boundary of the hot disk and width is a tenth of the hot disk size. Error of the outer boundary
+// condition and of the hot zone size dominates on coarse grids, while the log grid is already dense near the inner
+// boundary and refinement there or in the regions of large curvature of F gives larger total error
+vecd FreddiEvolution::remeshDensity(const vecd& h, const size_t first, const size_t last) const {
+	const size_t N = h.size() - 1;
+	const double width = 0.1 * (h[last] - h[first]);
+	vecd density(N);
+	for (size_t j = 0; j < N; ++j) {
+		const double h_mid = 0.5 * (h[j] + h[j + 1]);
+		density[j] = args().calc->gridscale == "log" ? 1. / h_mid : 1.;
+		if (j >= first && j < last) {
+			density[j] *= 1. + args().calc->remesh_refine * std::exp(-(h[last] - h_mid) / width);
+		}
+	}
+	return density;
+}
+
+
+// Places new grid points h_new[k_begin..k_end] in [h[i_begin], h[i_end]] so the integral of the piecewise-constant
+// density over every new interval is the same
+void FreddiEvolution::equidistribute(const vecd& h, const vecd& density, const size_t i_begin, const size_t i_end,
+									 vecd& h_new, const size_t k_begin, const size_t k_end) {
+	double total = 0.;
+	for (size_t j = i_begin; j < i_end; ++j) {
+		total += density[j] * (h[j + 1] - h[j]);
+	}
+	h_new[k_begin] = h[i_begin];
+	h_new[k_end] = h[i_end];
+	size_t j = i_begin;
+	double integral = 0.;
+	for (size_t k = k_begin + 1; k < k_end; ++k) {
+		const double target = total * (k - k_begin) / (k_end - k_begin);
+		while (j + 1 < i_end && integral + density[j] * (h[j + 1] - h[j]) < target) {
+			integral += density[j] * (h[j + 1] - h[j]);
+			++j;
+		}
+		h_new[k] = std::min(h[j] + (target - integral) / density[j], h[j + 1]);
+	}
+}
+
+
+// Linear interpolation of y(h) to the points h_new, both grids are increasing and have the same end points
+vecd FreddiEvolution::interpolate(const vecd& h, const vecd& y, const vecd& h_new) {
+	vecd y_new(h_new.size());
+	size_t j = 0;
+	for (size_t k = 0; k < h_new.size(); ++k) {
+		while (j + 2 < h.size() && h[j + 1] < h_new[k]) {
+			++j;
+		}
+		const double w = (h_new[k] - h[j]) / (h[j + 1] - h[j]);
+		y_new[k] = (1. - w) * y[j] + w * y[j + 1];
+	}
+	return y_new;
+}
+
+
+// Index of the point of h_new nearest to h[i]
+size_t FreddiEvolution::remapIndex(const vecd& h, const vecd& h_new, const size_t i) {
+	const size_t k = std::lower_bound(h_new.begin(), h_new.end(), h[i]) - h_new.begin();
+	if (k == h_new.size() || (k > 0 && h[i] - h_new[k - 1] < h_new[k] - h[i])) {
+		return k - 1;
+	}
+	return k;
+}
+
+
+// Builds new grid of the same size with points equidistributing remeshDensity(). Disk boundaries stay grid points,
+// the outer boundary of the hot disk is moved inwards to h_hot if it is smaller than h[last]. The inner region
+// [0, first], the hot disk [first, last] and the cold disk [last, Nx - 1] get numbers of intervals proportional to
+// the density integrals over them. W is linearly interpolated to the new grid and scaled to keep the integral of W
+// over h, which is the mass of the hot disk, and F is found from W
+void FreddiEvolution::remesh(const double h_hot) {
+	const size_t last_old = this->last();
+	if (remeshed_ && h_hot < this->h()[last_old] && last_old >= first() + 2) {
+		// The boundary is moved inside the last interval, only this point is moved if the interval stays long enough
+		const vecd& h_old = this->h();
+		if (h_hot - h_old[last_old - 1] >= 0.5 * (h_old[last_old - 1] - h_old[last_old - 2])) {
+			vecd h_new(h_old);
+			vecd F_new(F());
+			const double w = (h_hot - h_old[last_old - 1]) / (h_old[last_old] - h_old[last_old - 1]);
+			F_new[last_old] = (1. - w) * F_new[last_old - 1] + w * F_new[last_old];
+			h_new[last_old] = h_hot;
+			setGrid(std::move(h_new), std::move(F_new), first(), last_old);
+			return;
+		}
+	}
+
+	// Old grid with h_hot inserted
+	vecd h = this->h();
+	vecd F = this->F();
+	size_t last = this->last();
+	bool inserted = false;
+	if (h_hot < h[last]) {
+		last = std::lower_bound(h.begin(), h.end(), h_hot) - h.begin();
+		if (h[last] != h_hot) {
+			const double w = (h_hot - h[last - 1]) / (h[last] - h[last - 1]);
+			F.insert(F.begin() + last, (1. - w) * F[last - 1] + w * F[last]);
+			h.insert(h.begin() + last, h_hot);
+			inserted = true;
+		}
+	}
+	const size_t N_old = h.size() - 1;
+	const size_t N = Nx() - 1;
+	const vecd density = remeshDensity(h, first(), last);
+	double integral_inner = 0., integral_hot = 0., integral_cold = 0.;
+	for (size_t j = 0; j < N_old; ++j) {
+		const double dI = density[j] * (h[j + 1] - h[j]);
+		if (j < first()) {
+			integral_inner += dI;
+		} else if (j < last) {
+			integral_hot += dI;
+		} else {
+			integral_cold += dI;
+		}
+	}
+	const double integral = integral_inner + integral_hot + integral_cold;
+	const size_t n_inner = first() > 0 ? std::max<size_t>(1, std::lround(N * integral_inner / integral)) : 0;
+	const size_t n_cold = last < N_old ? std::max<size_t>(1, std::lround(N * integral_cold / integral)) : 0;
+	if (n_inner + n_cold + 2 > N) {
+		// Grid is too small to be rebuilt, the boundary is moved to the nearest inner grid point
+		if (last != this->last()) {
+			set_last(inserted ? last - 1 : last);
+		}
+		return;
+	}
+	const size_t first_new = n_inner;
+	const size_t last_new = N - n_cold;
+
+	vecd h_new(Nx());
+	if (first() > 0) {
+		equidistribute(h, density, 0, first(), h_new, 0, first_new);
+	}
+	equidistribute(h, density, first(), last, h_new, first_new, last_new);
+	if (last < N_old) {
+		equidistribute(h, density, last, N_old, h_new, last_new, N);
+	}
+
+	vecd F_new;
+	if (i_t() == 0) {
+		// Initial condition is known for any grid
+		F_new = args().disk->initial_F(h_new);
+	} else {
+		vecd W_old(h.size());
+		wunction(h, F, W_old, first(), last);
+		const vecd W_new = interpolate(h, W_old, h_new);
+		const double mass_first = 0.5 * W_new[first_new] * (h_new[first_new + 1] - h_new[first_new]);
+		const double scale = (trapz(h, W_old, first(), last) - mass_first) /
+							 (trapz(h_new, W_new, first_new, last_new) - mass_first);
+		F_new = interpolate(h, F, h_new);
+		oprel().dispatch([&](auto opacity) {
+			typedef decltype(opacity) Opacity;
+			for (size_t i = first_new + 1; i <= last_new; ++i) {
+				const double coef = Opacity::n_pow(h_new[i]) / (1. - Opacity::m) / oprel().D;
+				F_new[i] = std::pow(scale * W_new[i] / coef, 1. / (1. - Opacity::m));
+			}
+		});
+	}
+
+	setGrid(std::move(h_new), std::move(F_new), first_new, last_new);
+}
+
+
+// Replaces the grid and remaps the viscous torque of previous steps to it
+void FreddiEvolution::setGrid(vecd&& h_new, vecd&& F_new, const size_t first_new, const size_t last_new) {
+	for (auto prev : {&prev_, &prev2_}) {
+		if (prev->tau > 0.) {
+			prev->F = interpolate(h(), prev->F, h_new);
+			prev->first = remapIndex(h(), h_new, prev->first);
+			prev->last = remapIndex(h(), h_new, prev->last);
+		}
+	}
+
+	replaceGrid(std::move(h_new), std::move(F_new), first_new, last_new);
+	current_.tau_prev = 0.;
+	diffusion_.invalidate_coefficients();
+	wind_revision_ = wind_->revision();
+	remeshed_ = true;
+	remesh_first_ = first_new;
+	remesh_last_ = last_new;
+}
+
+
+// Moves the outer boundary of the hot disk to the position found by the last truncateOuterRadius, see --movingboundary
+void FreddiEvolution::moveOuterBoundary() {
+	if (front_h_) {
+		const double h_hot = *front_h_;
+		front_h_ = boost::none;
+		remesh(h_hot);
+	}
+}
+
+
 void FreddiEvolution::truncateOuterRadius() {
+	front_h_ = boost::none;
 	if (args().disk->Thot <= 0. ){
 		return;
 	}
@@ -42,42 +537,202 @@ void FreddiEvolution::truncateOuterRadius() {
 		return;
 	}
 
-	auto ii = last() + 1;
+	// Conditions of the hot disk: a point is hot if any of the margins is non-negative
+	std::function<vecd (size_t)> hot_margins;
 	if (Tirr().at(last()) / Tph_vis().at(last()) < args().disk->Tirr2Tvishot) {
 	// when irradiation is not important
 	// hot disc extends as far as Sigma>Sigma_max_cold(alpha_cold) and not farther than R_cooling_front and Tirr <= Thot 
-		do {
-			ii--;
-			if (ii <= first()) throw RadiusCollapseException();
-		  } while( ( R().at(ii) > R_cooling_front ( R().at(ii)) ) && ( Sigma().at(ii) < Sigma_minus(R().at(ii)) ) && ( Tirr().at(ii) < args().disk->Thot ) );
-		//} while( ( R().at(ii) > R_cooling_front ( R().at(ii)) ) && ( Sigma().at(ii) < Sigma_minus(R().at(ii)) ) );
+		hot_margins = [this](size_t i) -> vecd {
+			return {R_cooling_front(R().at(i)) - R().at(i), Sigma().at(i) - Sigma_minus(R().at(i)), Tirr().at(i) - args().disk->Thot};
+		};
 	} else if (args().disk->boundcond == "Teff") {
 	// irradiation is important, the boundary is at fixed Teff
-		do {
-			ii--;
-			if (ii <= first()) throw RadiusCollapseException();
-		} while( Tph().at(ii) < args().disk->Thot );
+		hot_margins = [this](size_t i) -> vecd { return {Tph().at(i) - args().disk->Thot}; };
 	} else if (args().disk->boundcond == "Tirr") {
 	// irradiation is important, the boundary is at fixed Tir
-		do {
-			ii--;
-			if (ii <= first()) throw RadiusCollapseException();
-		} while( Tirr().at(ii) < args().disk->Thot );
+		hot_margins = [this](size_t i) -> vecd { return {Tirr().at(i) - args().disk->Thot}; };
 	} else{
 		throw std::invalid_argument("Wrong boundcond");
 	}
 
+	auto ii = last() + 1;
+	vecd margins;
+	do {
+		ii--;
+		if (ii <= first()) throw RadiusCollapseException();
+		margins = hot_margins(ii);
+	} while( *std::max_element(margins.begin(), margins.end()) < 0. );
+
 	if ( ii <= last() - 1 ){
-		current_.last = ii;
-		invalidate_optional_structure();
+		if (args().calc->remesh && args().calc->moving_boundary) {
+			// The boundary is where the first of the margins linearly interpolated between ii and ii + 1 becomes negative
+			const vecd margins_cold = hot_margins(ii + 1);
+			double w = 0.;
+			for (size_t k = 0; k < margins.size(); ++k) {
+				if (margins[k] >= 0.) {
+					w = std::max(w, margins[k] / (margins[k] - margins_cold[k]));
+				}
+			}
+			front_h_ = h()[ii] + w * (h()[ii + 1] - h()[ii]);
+		} else {
+			set_last(ii);
+		}
 	}
 }
 
 
-vecd FreddiEvolution::wunction(const vecd &h, const vecd &F, size_t _first, size_t _last) const {
-	vecd W(_last + 1, 0.);
+void FreddiEvolution::wunction(const vecd &h, const vecd &F, vecd &W, size_t _first, size_t _last) const {
+	oprel().dispatch([&](auto opacity) {
+		typedef decltype(opacity) Opacity;
+		// h-dependent factor is precomputed for the disk grid
+		if (&h == &this->h()) {
+			const vecd& coef = wunc_coef();
+			for ( size_t i = _first; i <= _last; ++i ){
+				W[i] = Opacity::one_minus_m_pow(std::abs(F[i])) * coef[i];
+			}
+			return;
+		}
+		for ( size_t i = _first; i <= _last; ++i ){
+			W[i] = Opacity::one_minus_m_pow(std::abs(F[i])) * (Opacity::n_pow(h[i]) / (1. - Opacity::m) / oprel().D);
+		}
+	});
+}
+
+
+void FreddiEvolution::dwunction(const vecd &h, const vecd &F, const vecd &W, vecd &dW, size_t _first, size_t _last) const {
 	for ( size_t i = _first; i <= _last; ++i ){
-		W[i] = pow(std::abs(F[i]), 1. - oprel().m) * pow(h[i], oprel().n) / (1. - oprel().m) / oprel().D;
+		dW[i] = (1. - oprel().m) * W[i] / F[i];
+	}
+}
+
+
+FreddiEvolutionBatch::FreddiEvolutionBatch(const std::vector<FreddiArguments>& args):
+		disks_(initializeDisks(args)),
+		lockstep_(initializeLockstep(disks_)),
+		diffusion_(disks_.size(), disks_.front()->Nx()) {
+	const size_t L = size();
+	const size_t Nx = disks_.front()->Nx();
+	h_.resize(Nx * L);
+	wunc_coef_.resize(Nx * L);
+	for (auto v : {&F_, &A_, &B_, &C_}) {
+		v->resize(Nx * L);
+	}
+	for (auto v : {&tau_, &eps_, &F_in_, &Mdot_out_, }) {
+		v->resize(L);
+	}
+	for (size_t l = 0; l < L; ++l) {
+		const auto& disk = *disks_[l];
+		for (size_t i = 0; i < Nx; ++i) {
+			h_[i * L + l] = disk.h()[i];
+			wunc_coef_[i * L + l] = disk.wunc_coef()[i];
+		}
+		tau_[l] = disk.args().calc->tau;
+		eps_[l] = disk.args().calc->eps;
+	}
+}
+
+
+std::vector<std::unique_ptr<FreddiEvolution>> FreddiEvolutionBatch::initializeDisks(const std::vector<FreddiArguments>& args) {
+	if (args.empty()) {
+		throw std::invalid_argument("Batch should contain at least one disk");
+	}
+	std::vector<std::unique_ptr<FreddiEvolution>> disks;
+	for (const auto& disk_args : args) {
+		disks.emplace_back(new FreddiEvolution(disk_args));
+		if (disks.back()->Nx() != disks.front()->Nx()) {
+			throw std::invalid_argument("All disks in batch should have the same Nx");
+		}
+	}
+	return disks;
+}
+
+
+bool FreddiEvolutionBatch::initializeLockstep(const std::vector<std::unique_ptr<FreddiEvolution>>& disks) {
+	for (const auto& disk : disks) {
+		if (disk->args().calc->adaptive_tau || disk->bdf2_ || disk->args().calc->remesh || disk->args().calc->predictor
+				|| disk->implicit_wind_) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// The same as FreddiEvolution::wunction for every disk
+void FreddiEvolutionBatch::wunction(const vecd &h, const vecd &F, vecd &W, size_t _first, size_t _last) const {
+	const size_t L = size();
+	for (size_t l = 0; l < L; ++l) {
+		disks_[l]->oprel().dispatch([&](auto opacity) {
+			typedef decltype(opacity) Opacity;
+			for (size_t j = _first * L + l; j <= _last * L + l; j += L) {
+				W[j] = Opacity::one_minus_m_pow(std::abs(F[j])) * wunc_coef_[j];
+			}
+		});
+	}
+}
+
+
+void FreddiEvolutionBatch::lockstepDiffusion() {
+	const size_t L = size();
+	const size_t first = disks_.front()->first();
+	const size_t last = disks_.front()->last();
+	for (size_t l = 0; l < L; ++l) {
+		auto& disk = *disks_[l];
+		const auto& A = disk.windA();
+		const auto& B = disk.windB();
+		const auto& C = disk.windC();
+		for (size_t i = first; i <= last; ++i) {
+			F_[i * L + l] = disk.F()[i];
+			A_[i * L + l] = A[i];
+			B_[i * L + l] = B[i];
+			C_[i * L + l] = C[i];
+		}
+		F_in_[l] = disk.F_in();
+		Mdot_out_[l] = disk.Mdot_out();
+	}
+	diffusion_(
+			tau_, eps_,
+			F_in_, Mdot_out_,
+			A_, B_, C_,
+			[this](const vecd& h, const vecd& F, vecd& W, size_t first, size_t last) {
+				wunction(h, F, W, first, last);
+			},
+			h_, F_,
+			first, last);
+	for (size_t l = 0; l < L; ++l) {
+		auto& disk = *disks_[l];
+		for (size_t i = first; i <= last; ++i) {
+			disk.current_.F[i] = F_[i * L + l];
+		}
+		disk.current_.nonlinear_iterations = diffusion_.iterations()[l];
+		disk.current_.nonlinear_residual = diffusion_.residual()[l];
+	}
+}
+
+
+void FreddiEvolutionBatch::step() {
+	if (!lockstep_) {
+		for (auto& disk : disks_) {
+			disk->step();
+		}
+		return;
+	}
+	for (auto& disk : disks_) {
+		disk->prepareStep(disk->args().calc->tau);
 	}
-	return W;
-};
+	bool same_boundaries = true;
+	for (const auto& disk : disks_) {
+		same_boundaries = same_boundaries && disk->first() == disks_.front()->first() && disk->last() == disks_.front()->last();
+	}
+	if (same_boundaries) {
+		lockstepDiffusion();
+	} else {
+		for (auto& disk : disks_) {
+			disk->solveDiffusion(disk->args().calc->tau);
+		}
+	}
+	for (auto& disk : disks_) {
+		disk->finishStep();
+		disk->current_.substeps = 1;
+	}
+}
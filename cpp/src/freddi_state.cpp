@@ -11,9 +11,12 @@
 
 
 FreddiState::DiskStructure::DiskStructure(const FreddiArguments &args, const wunc_t& wunc):
+		DiskStructure(args, wunc, initialize_h(args, args.calc->Nx)) {}
+
+FreddiState::DiskStructure::DiskStructure(const FreddiArguments &args, const wunc_t& wunc, vecd&& h):
 		args(args),
 		Nt(static_cast<size_t>(std::round(args.calc->time / args.calc->tau))),
-		Nx(args.calc->Nx),
+		Nx(h.size()),
 		GM(GSL_CONST_CGSM_GRAVITATIONAL_CONSTANT * args.basic->Mx),
 		R_g(GSL_CONST_CGSM_GRAVITATIONAL_CONSTANT * args.basic->Mx / m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT)),
 		eta(efficiency_of_accretion(args.basic->kerr)),
@@ -23,8 +26,14 @@ FreddiState::DiskStructure::DiskStructure(const FreddiArguments &args, const wun
 		distance(args.flux->distance),
 		cosiOverD2(cosi / m::pow<2>(distance)),
 		oprel(args.disk->oprel),
-		h(initialize_h(args, Nx)),
-		R(initialize_R(h, GM)),
+		h(std::move(h)),
+		R(initialize_R(this->h, GM)),
+		wunc_coef(initialize_wunc_coef(this->h, oprel)),
+		W_to_Sigma(initialize_grid_factor(this->h, [GM = GM](double h) { return m::pow<2>(GM) / (4. * M_PI * m::pow<3>(h)); })),
+		Sigma_to_W(initialize_grid_factor(this->h, [GM = GM](double h) { return (4.0 * M_PI * m::pow<3>(h)) / (m::pow<2>(GM)); })),
+		Tph_vis_coef(initialize_grid_factor(this->h, [GM = GM](double h) { return GM * std::pow(h, -1.75); })),
+		Qvis_coef(initialize_grid_factor(this->h, [GM = GM](double h) { return 3. / (8. * M_PI) * m::pow<4>(GM) / m::pow<7>(h); })),
+		Qvis_GR_coef(initialize_grid_factor(this->h, [GM = GM, kerr = args.basic->kerr, Mx = args.basic->Mx](double h) { return Spectrum::Qvis_GR_coef(m::pow<2>(h) / GM, kerr, Mx); })),
 		wunc(wunc) {}
 
 vecd FreddiState::DiskStructure::initialize_h(const FreddiArguments& args, size_t Nx) {
@@ -52,10 +61,30 @@ vecd FreddiState::DiskStructure::initialize_R(const vecd& h, double GM) {
 	return R;
 }
 
+vecd FreddiState::DiskStructure::initialize_wunc_coef(const vecd& h, const OpacityRelated& oprel) {
+	return oprel.dispatch([&h, &oprel](auto opacity) {
+		typedef decltype(opacity) Opacity;
+		vecd coef(h.size());
+		for (size_t i = 0; i < h.size(); i++) {
+			coef[i] = Opacity::n_pow(h[i]) / (1. - Opacity::m) / oprel.D;
+		}
+		return coef;
+	});
+}
+
+vecd FreddiState::DiskStructure::initialize_grid_factor(const vecd& h, const std::function<double (double)>& f) {
+	vecd factor(h.size());
+	for (size_t i = 0; i < h.size(); i++) {
+		factor[i] = f(h[i]);
+	}
+	return factor;
+}
+
 
 FreddiState::CurrentState::CurrentState(const DiskStructure& str):
 		Mdot_out(str.args.disk->Mdotout),
 		t(str.args.calc->init_time),
+		tau(str.args.calc->tau),
 		i_t(0),
 		first(initializeFirst(str)),
 		last(str.Nx - 1),
@@ -133,23 +162,102 @@ std::shared_ptr<FreddiState::BasicFreddiIrradiationSource> FreddiState::initiali
 }
 
 
-void FreddiState::invalidate_optional_structure() {
-	opt_str_ = DiskOptionalStructure();
+// Quantities depending on the changed ones are invalidated completely, local quantities depending on the locally
+// changed ones only become partially invalid
+void FreddiState::DiskOptionalStructure::invalidate(unsigned int changed, unsigned int changed_locally) {
+	for (const auto& dependency : dependencies) {
+		if (dependency.depends_on & changed) {
+			changed |= dependency.quantity;
+		} else if (dependency.depends_on & changed_locally) {
+			(dependency.local ? changed_locally : changed) |= dependency.quantity;
+		}
+	}
+	valid_profiles &= ~changed;
+	partial_profiles = (partial_profiles | changed_locally) & valid_profiles;
+	if (changed & MdiskValue) {
+		Mdisk = boost::none;
+	}
+	if (changed & LxValue) {
+		Lx = boost::none;
+	}
+	if (changed & MdotWindValue) {
+		Mdot_wind = boost::none;
+	}
+}
+
+
+void FreddiState::DiskOptionalStructure::invalidate_cells(const size_t i_begin, const size_t i_end) {
+	if (partial_profiles == 0) {
+		dirty_first = i_begin;
+		dirty_last = i_end;
+	} else {
+		dirty_first = std::min(dirty_first, i_begin);
+		dirty_last = std::max(dirty_last, i_end);
+	}
+	invalidate(0, ChangedLast);
+}
+
+
+void FreddiState::invalidate_optional_structure(const unsigned int changed) {
+	opt_str_.invalidate(changed);
+}
+
+
+void FreddiState::set_last(const size_t last) {
+	if (last == current_.last) {
+		return;
+	}
+	opt_str_.invalidate_cells(std::min(last, current_.last) + 1, std::max(last, current_.last));
+	current_.last = last;
+}
+
+
+bool FreddiState::invalid_cells(const unsigned int profiles, const std::initializer_list<vecd*> buffers,
+								size_t& i_begin, size_t& i_end) {
+	if (opt_str_.valid(profiles)) {
+		return false;
+	}
+	if ((opt_str_.valid_profiles & profiles) == profiles) {
+		i_begin = opt_str_.dirty_first;
+		i_end = opt_str_.dirty_last;
+		for (vecd* x : buffers) {
+			std::fill(x->begin() + i_begin, x->begin() + i_end + 1, 0.0);
+		}
+	} else {
+		i_begin = 0;
+		i_end = Nx() - 1;
+		for (vecd* x : buffers) {
+			x->assign(Nx(), 0.0);
+		}
+	}
+	return true;
 }
 
 
 void FreddiState::replaceArgs(const FreddiArguments &args) {
 	str_.reset(new DiskStructure(args, wunc()));
-	invalidate_optional_structure();
+	invalidate_optional_structure(ChangedAll);
 }
 
+void FreddiState::replaceGrid(vecd&& h, vecd&& F, const size_t first, const size_t last) {
+	str_.reset(new DiskStructure(args(), wunc(), std::move(h)));
+	current_.F = std::move(F);
+	current_.first = first;
+	current_.last = last;
+	invalidate_optional_structure(ChangedAll);
+	initializeWind();
+}
 
+
+// Viscous torque is going to be changed by the step, the inner boundary can be already changed before it
 void FreddiState::step(double tau) {
 	set_Mdot_in_prev();
-	invalidate_optional_structure();
 	current_.i_t ++;
 	current_.t += tau;
+	current_.tau = tau;
+	const unsigned int wind_revision = wind_->revision();
 	wind_->update(*this);
+	invalidate_optional_structure(ChangedF | ChangedFirst | (wind_->revision() != wind_revision ? ChangedWind : 0u));
 }
 
 
@@ -182,133 +290,133 @@ double FreddiState::Fx() {
 
 
 const vecd& FreddiState::W() {
-	if (!opt_str_.W) {
-		auto x = wunc()(h(), F(), first(), last());
-		x.resize(Nx(), 0.0);
-		opt_str_.W = std::move(x);
+	size_t i_begin, i_end;
+	if (invalid_cells(DiskOptionalStructure::WProfile, {&opt_str_.W}, i_begin, i_end)) {
+		const size_t i_first = std::max(i_begin, first());
+		const size_t i_last = std::min(i_end, last());
+		if (i_first <= i_last) {
+			wunc()(h(), F(), opt_str_.W, i_first, i_last);
+		}
+		opt_str_.validate(DiskOptionalStructure::WProfile);
 	}
-	return *opt_str_.W;
+	return opt_str_.W;
 }
 
 
 const vecd& FreddiState::Sigma() {
-	if (!opt_str_.Sigma) {
-		vecd x(Nx());
+	size_t i_begin, i_end;
+	if (invalid_cells(DiskOptionalStructure::SigmaProfile, {&opt_str_.Sigma}, i_begin, i_end)) {
 		const vecd& WW = W();
-		for (size_t i = first(); i < Nx(); i++) {
-			x[i] = WW[i] * m::pow<2>(GM()) / (4. * M_PI * m::pow<3>(h()[i]));
+		vecd& x = opt_str_.Sigma;
+		for (size_t i = std::max(i_begin, first()); i <= i_end; i++) {
+			x[i] = WW[i] * W_to_Sigma()[i];
 		}
-		opt_str_.Sigma = std::move(x);
+		opt_str_.validate(DiskOptionalStructure::SigmaProfile);
 	}
-	return *opt_str_.Sigma;
+	return opt_str_.Sigma;
 }
 
 
-const vecd& FreddiState::Tph() {
-	if (!opt_str_.Tph) {
-		vecd x(Nx());
-		const vecd& Tvis = Tph_vis();
-		const vecd& QxQx = Qx();
-		for (size_t i = first(); i < Nx(); i++) {
-			x[i] = std::pow(m::pow<4>(Tvis[i]) + QxQx[i] / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT, 0.25);
+std::function<double (double)> FreddiState::irradiating_luminosity() const {
+	const double Lbol = Lbol_disk();
+	return [this, Lbol](const double mu) -> double { return Lbol * angular_dist_disk(mu); };
+}
+
+
+// Profiles are used together by output and truncation of the hot disk, so they are calculated at once to avoid
+// repeated passes over the grid
+void FreddiState::calculate_irradiation_profiles() {
+	vecd& H = opt_str_.Height;
+	vecd& K = opt_str_.Kirr;
+	vecd& Q = opt_str_.Qx;
+	vecd& T_irr = opt_str_.Tirr;
+	vecd& T_vis = opt_str_.Tph_vis;
+	vecd& T_ph = opt_str_.Tph;
+	size_t i_begin, i_end;
+	if (!invalid_cells(DiskOptionalStructure::IrradiationProfiles, {&H, &K, &Q, &T_irr, &T_vis, &T_ph}, i_begin, i_end)) {
+		return;
+	}
+	const auto luminosity = irradiating_luminosity();
+	const auto& irr = *args().irr;
+	const auto irradiate = [&](const size_t i) {
+		Q[i] = K[i] * luminosity(H[i] / R()[i]) / (4. * M_PI * m::pow<2>(R()[i]));
+		T_irr[i] = std::pow(Q[i] / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT, 0.25);
+		T_ph[i] = std::pow(m::pow<4>(T_vis[i]) + Q[i] / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT, 0.25);
+	};
+	oprel().dispatch([&](auto opacity) {
+		for (size_t i = std::max(i_begin, first()); i <= std::min(i_end, last()); i++) {
+			H[i] = oprel().Height(opacity, R()[i], F()[i]);
+			K[i] = irr.Cirr * std::pow(H[i] / (R()[i] * 0.05), irr.irrindex);
+			T_vis[i] = (Tph_vis_coef()[i]
+					* std::pow(3. / (8. * M_PI) * F()[i] / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT, 0.25));
+			irradiate(i);
 		}
-		opt_str_.Tph = std::move(x);
+	});
+	for (size_t i = std::max(i_begin, last() + 1); i <= i_end; i++) {
+		H[i] = irr.height_to_radius_cold * R()[i];
+		K[i] = irr.Cirr_cold * std::pow(H[i] / (R()[i] * 0.05), irr.irrindex_cold);
+		irradiate(i);
 	}
-	return *opt_str_.Tph;
+	opt_str_.validate(DiskOptionalStructure::IrradiationProfiles);
+}
+
+
+const vecd& FreddiState::Tph() {
+	calculate_irradiation_profiles();
+	return opt_str_.Tph;
 }
 
 
 const vecd& FreddiState::Tirr() {
-	if (!opt_str_.Tirr) {
-		vecd x(Nx());
-		const vecd& QxQx = Qx();
-		for (size_t i = first(); i < Nx(); i++) {
-			x[i] = std::pow(QxQx[i] / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT, 0.25);
-		}
-		opt_str_.Tirr = std::move(x);
-	}
-	return *opt_str_.Tirr;
+	calculate_irradiation_profiles();
+	return opt_str_.Tirr;
 }
 
 
 const vecd& FreddiState::Qx() {
-	if (!opt_str_.Qx) {
-		vecd x(Nx());
-		const vecd& K = Kirr();
-		const vecd& H = Height();
-		const double Lbol = Lbol_disk();
-		for (size_t i = first(); i < Nx(); i++) {
-			x[i] = K[i] * Lbol * angular_dist_disk(H[i] / R()[i]) / (4. * M_PI * m::pow<2>(R()[i]));
-		}
-		opt_str_.Qx = std::move(x);
-	}
-	return *opt_str_.Qx;
+	calculate_irradiation_profiles();
+	return opt_str_.Qx;
 }
 
 
 const vecd& FreddiState::Kirr() {
-	if(!opt_str_.Kirr) {
-		vecd x(Nx());
-		const vecd& H = Height();
-		for (size_t i = first(); i <= last(); i++) {
-			x[i] = args().irr->Cirr * std::pow(H[i] / (R()[i] * 0.05), args().irr->irrindex);
-		}
-		for (size_t i = last() + 1; i < Nx(); i++) {
-			x[i] = args().irr->Cirr_cold * std::pow(H[i] / (R()[i] * 0.05), args().irr->irrindex_cold);
-		}
-		opt_str_.Kirr = std::move(x);
-	}
-	return *opt_str_.Kirr;
+	calculate_irradiation_profiles();
+	return opt_str_.Kirr;
 }
 
 
 const vecd& FreddiState::Height() {
-	if (!opt_str_.Height) {
-		vecd x(Nx());
-		for (size_t i = first(); i <= last(); i++) {
-			x[i] = oprel().Height(R()[i], F()[i]);
-		}
-		for (size_t i = last() + 1; i < Nx(); i++) {
-			x[i] = args().irr->height_to_radius_cold * R()[i];
-		}
-		opt_str_.Height = std::move(x);
-	}
-	return *opt_str_.Height;
+	calculate_irradiation_profiles();
+	return opt_str_.Height;
 }
 
 
 const vecd& FreddiState::Tph_vis() {
-	if (!opt_str_.Tph_vis) {
-		vecd x(Nx(), 0.0);
-		for (size_t i = first(); i <= last(); i++) {
-			x[i] = (GM() * std::pow(h()[i], -1.75)
-					* std::pow(3. / (8. * M_PI) * F()[i] / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT, 0.25));
-		}
-		opt_str_.Tph_vis = std::move(x);
-	}
-	return *opt_str_.Tph_vis;
+	calculate_irradiation_profiles();
+	return opt_str_.Tph_vis;
 }
 
 const vecd& FreddiState::Tph_X() {
-	if (!opt_str_.Tph_X) {
-		vecd x(Nx(), 0.0);
+	size_t i_begin, i_end;
+	if (invalid_cells(DiskOptionalStructure::TphXProfile, {&opt_str_.Tph_X}, i_begin, i_end)) {
+		vecd& x = opt_str_.Tph_X;
 		const double Mdot = std::fabs((F()[first()+1] - F()[first()]) / (h()[first()+1] - h()[first()]));
-		for (size_t i = first(); i <= last(); i++) {
+		for (size_t i = std::max(i_begin, first()); i <= std::min(i_end, last()); i++) {
 			//
 
 			// Qvis due to non-zero Fin:
-			x[i] =  3. / (8. * M_PI) * m::pow<4>(GM()) / m::pow<7>(h()[i]) * F()[first()];
+			x[i] =  Qvis_coef()[i] * F()[first()];
 
 			// Qvis due to non-zero Mdot:  = sigma * Trel(dotM)^4
 			//      assume that Mdot ~= const where X-rays are generated
 			//      dotM = dF/dh
-			x[i] += m::pow<4>(Spectrum::T_GR(R()[i], args().basic->kerr, args().basic->Mx, Mdot)) * GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT;
+			x[i] += Qvis_GR_coef()[i] * Mdot;
 
 			x[i] = args().flux->colourfactor * std::pow( x[i] / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT , 0.25);
 		}
-		opt_str_.Tph_X = std::move(x);
+		opt_str_.validate(DiskOptionalStructure::TphXProfile);
 	}
-	return *opt_str_.Tph_X;
+	return opt_str_.Tph_X;
 }
 
 
@@ -336,12 +444,22 @@ double FreddiState::lazy_magnitude(boost::optional<double>& m, double lambda, do
 }
 
 
+double FreddiState::I_lambda(const vecd& T, const double lambda, const size_t first, const size_t last) const {
+	if (first > last) {
+		return 0.;
+	}
+	vecd B(last - first + 1);
+	Spectrum::Planck_lambda(T.data() + first, B.size(), lambda, B.data());
+	return disk_radial_trapz(R(), [&B, first](const size_t i) -> double { return B[i - first]; }, first, last);
+}
+
+
 double FreddiState::Luminosity(const vecd& T, double nu1, double nu2) const {
 	// 2 - two sides
 	// pi = \int cos(phi) dtheta dphi
 	// pi * \int Bnu dnu gives flux
 	// 2 * \int dS gives disk area on both sides
-	return 2. * M_PI * integrate<HotRegion>([&T, nu1, nu2](const size_t i) -> double { return Spectrum::Planck_nu1_nu2(T[i], nu1, nu2, 1e-4); });
+	return 2. * M_PI * integrate<HotRegion>([&T, nu1, nu2](const size_t i) -> double { return Spectrum::Planck_nu1_nu2(T[i], nu1, nu2); });
 }
 
 
@@ -362,7 +480,10 @@ double FreddiState::flux_star(const EnergyPassband& passband, const double phase
 
 
 double FreddiState::Mdot_wind() {
-	auto dMdot_dh = [this](const size_t i) -> double {
+	const vecd& A = windA();
+	const vecd& B = windB();
+	const vecd& C = windC();
+	auto dMdot_dh = [this, &A, &B, &C](const size_t i) -> double {
 		double dFdh;
 		if (i == first()) {
 			dFdh = (F()[i+1] - F()[i]) / (h()[i+1] - h()[i]);
@@ -377,7 +498,7 @@ double FreddiState::Mdot_wind() {
 					(delta_0 * delta_1);
 		}
 		// Wind loss rate sign is opposite disk loss rate sign, e.g. usually it should be positive
-		return -(windA()[i] * dFdh + windB()[i] * F()[i] + windC()[i]);
+		return -(A[i] * dFdh + B[i] * F()[i] + C[i]);
 	};
 	return lazy_integrate<HotRegion>(opt_str_.Mdot_wind, h(), dMdot_dh);
 }
@@ -395,8 +516,7 @@ FreddiState::SS73CWind::SS73CWind(const FreddiState &state):
 						 GSL_CONST_CGSM_THOMSON_CROSS_SECTION * state.GM();
 	const double Mdot_crit = L_edd / (m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT) * state.eta());
 	for (size_t i = 0; i < state.Nx(); ++i) {
-		C_[i] = -Mdot_crit / (2 * M_PI * state.R().front() * state.R()[i]) *
-				(4 * M_PI * m::pow<3>(state.h()[i])) / m::pow<2>(state.GM());
+		C_[i] = -Mdot_crit / (2 * M_PI * state.R().front() * state.R()[i]) * state.Sigma_to_W()[i];
 	}
 }
 
@@ -412,7 +532,7 @@ FreddiState::Cambier2013Wind::Cambier2013Wind(const FreddiState& state):
 	const double R_iC = R_IC2out * state.R().back();
 	for (size_t i = 0; i < state.Nx(); ++i) {
 		const double xi = state.R()[i] / R_iC;
-		const double C0 = m_ch0 * (4.0 * M_PI * m::pow<3>(state.h()[i])) / (m::pow<2>(state.GM()));
+		const double C0 = m_ch0 * state.Sigma_to_W()[i];
 		C_[i] = C0 * std::pow((1 + m::pow<2>(0.125 * eta / xi))
 								  / (1 + 1. / (m::pow<8>(eta) * m::pow<2>(1 + 262 * m::pow<2>(xi)))), 1. / 6.)
 					* std::exp(-m::pow<2>(1 - 1. / std::sqrt(1 + 0.25 / (m::pow<2>(xi)))) / (2 * xi));
@@ -454,14 +574,13 @@ FreddiState::testCq0Shields1986Wind::testCq0Shields1986Wind(const FreddiState& s
 		C_w(state.args().disk->windparams.at("C_w")),
 		R_w(state.args().disk->windparams.at("R_w")) {}
 
-void FreddiState::testCq0Shields1986Wind::update(const FreddiState& state) {
-	BasicWind::update(state);
+void FreddiState::testCq0Shields1986Wind::update(const FreddiState& state, const double Mdot_in) {
+	BasicWind::update(state, Mdot_in);
 	const double h_wind_min = std::sqrt(R_w) * state.h().back();
 	for (size_t i = state.first(); i <= state.last(); ++i) {
 		if (state.h()[i] > h_wind_min) {
-			C_[i] = -0.5/M_PI * C_w * state.Mdot_in() /
-					(std::log(1 / R_w) * m::pow<2>(state.R()[i])) *
-					(4 * M_PI * m::pow<3>(state.h()[i])) / m::pow<2>(state.GM());
+			C_[i] = -0.5/M_PI * C_w * Mdot_in /
+					(std::log(1 / R_w) * m::pow<2>(state.R()[i])) * state.Sigma_to_W()[i];
 		}
 	}
 }
@@ -470,13 +589,13 @@ FreddiState::Janiuk2015Wind::Janiuk2015Wind(const FreddiState& state):
         BasicWind(state),
         A_0(state.args().disk->windparams.at("A_0")),
         B_1(state.args().disk->windparams.at("B_1")) {
-    update(state);
+    update(state, state.Mdot_in());
 }
 
-void FreddiState::Janiuk2015Wind::update(const FreddiState& state) {
-    BasicWind::update(state);
+void FreddiState::Janiuk2015Wind::update(const FreddiState& state, const double Mdot_in) {
+    BasicWind::update(state, Mdot_in);
     const auto disk = state.args().disk;
-    const double L = state.Mdot_in() * m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT) * state.eta();
+    const double L = Mdot_in * m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT) * state.eta();
     const double R_g = 2*state.GM()/(m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT));
     const double L_edd = (4.0 * M_PI * state.GM()* 2.0 * disk->mu * GSL_CONST_CGSM_MASS_PROTON * GSL_CONST_CGSM_SPEED_OF_LIGHT / GSL_CONST_CGSM_THOMSON_CROSS_SECTION);
     const double lol = L/L_edd;
@@ -488,8 +607,8 @@ void FreddiState::Janiuk2015Wind::update(const FreddiState& state) {
        //C_[i] =  B_1 * 3000.0 * v_r * R_g * fout * ( std::pow((state.R()[state.last()]/R_g), 0.2) - std::pow((state.R()[i]/R_g), 0.2) );
        //*( std::pow((state.R()[state.last()]/R_g), 0.2) - std::pow((state.R()[i]/R_g), 0.2)
             const double fout = 1 - 1/(1+A_0*m::pow<2>(lol));
-            const double C_0 = (4.0 * M_PI * m::pow<3>(state.h()[i])) / (m::pow<2>(state.GM()));
-            const double Q = 2 * (3/(8 * M_PI)) * ((m::pow<4>(state.GM()))/(m::pow<7>(state.h()[i])))  ;
+            const double C_0 = state.Sigma_to_W()[i];
+            const double Q = 2 * state.Qvis_coef()[i];
             B_[i] =  - 0.75 * C_0 * (1/B_1) * ((4 * Q * state.R()[i])/(3* state.GM()))*fout ; }
     }
 }
@@ -500,14 +619,14 @@ FreddiState::Shields1986Wind::Shields1986Wind(const FreddiState& state):
         Xi_max(state.args().disk->windparams.at("Xi_max")),
         T_ic(state.args().disk->windparams.at("T_ic")),
         Pow(state.args().disk->windparams.at("Pow")) {
-    update(state);
+    update(state, state.Mdot_in());
 }
 
-void FreddiState::Shields1986Wind::update(const FreddiState& state) {
-    BasicWind::update(state);
+void FreddiState::Shields1986Wind::update(const FreddiState& state, const double Mdot_in) {
+    BasicWind::update(state, Mdot_in);
     const auto disk = state.args().disk;
     //  1983ApJ...271...70B page 4
-    const double L = state.Mdot_in() * m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT) * state.eta();
+    const double L = Mdot_in * m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT) * state.eta();
     //  1983ApJ...271...70B page 3
     const double R_iC = (state.GM() * disk->mu * GSL_CONST_CGSM_MASS_PROTON)/(GSL_CONST_CGSM_BOLTZMANN * T_ic);
     const double L_edd = (4.0 * M_PI * state.GM()* 2.0 * disk->mu * GSL_CONST_CGSM_MASS_PROTON * GSL_CONST_CGSM_SPEED_OF_LIGHT / GSL_CONST_CGSM_THOMSON_CROSS_SECTION);
@@ -515,7 +634,7 @@ void FreddiState::Shields1986Wind::update(const FreddiState& state) {
     const double P_iC = L / (4.0 * M_PI * m::pow<2>(R_iC) * Xi_max * GSL_CONST_CGSM_SPEED_OF_LIGHT);
     const double el = L/L_crit;
     
-    	std::cerr << R_iC << "\t" << disk->mu << "\t" << P_iC << "\t" << state.eta() << "\t" << state.Mdot_in() << "\t" <<  L << "\t" << L_edd << "\t" << L_crit << "\t" <<  GSL_CONST_CGSM_MASS_ELECTRON << std::endl; 
+    	std::cerr << R_iC << "\t" << disk->mu << "\t" << P_iC << "\t" << state.eta() << "\t" << Mdot_in << "\t" <<  L << "\t" << L_edd << "\t" << L_crit << "\t" <<  GSL_CONST_CGSM_MASS_ELECTRON << std::endl; 
 	//std::cerr << "\t" << L << "\t" << R_iC  << "\t" << L_edd << "\t" << C_ch << "\t" << P_0 << "\t" << m_ch0 << std::endl;
 
     for (size_t i = state.first(); i <= state.last(); ++i) {
@@ -526,7 +645,7 @@ void FreddiState::Shields1986Wind::update(const FreddiState& state) {
             const double P_0 = L / (4.0 * M_PI * m::pow<2>(state.R()[i]) * Xi_max * GSL_CONST_CGSM_SPEED_OF_LIGHT);
             const double C_ch = std::sqrt((GSL_CONST_CGSM_BOLTZMANN * T_ch) / (disk->mu * GSL_CONST_CGSM_MASS_PROTON));
             const double m_ch0 = P_0/C_ch;
-            const double C0 = (4.0 * M_PI * m::pow<3>(state.h()[i])) / (m::pow<2>(state.GM()));
+            const double C0 = state.Sigma_to_W()[i];
             //  1986ApJ...306...90S appendix B page 16
             const double y = std::sqrt(1. + 1./(4.*m::pow<2>(xi)) + ((m::pow<2>(xi))/(1. + m::pow<2>(xi)))*((1.2*xi/(xi + el) + 2.2/(1. + m::pow<2>(el)*xi))*(1.2*xi/(xi + el) + 2.2/(1. + m::pow<2>(el)*xi))));
             const double Mach_cc = std::cbrt(((1. + (el + 1.)/xi)/(1. + 1./((1. + m::pow<2>(xi))*m::pow<4>(el)))));
@@ -540,13 +659,13 @@ FreddiState::Woods1996AGNWind::Woods1996AGNWind(const FreddiState& state):
         BasicWind(state),
         C_0(state.args().disk->windparams.at("C_0")),
         T_ic(state.args().disk->windparams.at("T_ic")) {
-    update(state);
+    update(state, state.Mdot_in());
 }
 
-void FreddiState::Woods1996AGNWind::update(const FreddiState& state) {
-    BasicWind::update(state);
+void FreddiState::Woods1996AGNWind::update(const FreddiState& state, const double Mdot_in) {
+    BasicWind::update(state, Mdot_in);
     const auto disk = state.args().disk;
-    const double L = state.Mdot_in() * m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT) * state.eta();
+    const double L = Mdot_in * m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT) * state.eta();
     const double L_edd = (4.0 * M_PI * state.GM()* 2.0 * disk->mu * GSL_CONST_CGSM_MASS_PROTON * GSL_CONST_CGSM_SPEED_OF_LIGHT / GSL_CONST_CGSM_THOMSON_CROSS_SECTION);
     const double R_iC = (state.GM() * disk->mu * GSL_CONST_CGSM_MASS_PROTON)/(GSL_CONST_CGSM_BOLTZMANN * T_ic);
     const double le = L/L_edd;
@@ -580,7 +699,7 @@ void FreddiState::Woods1996AGNWind::update(const FreddiState& state) {
             g_R = state.R()[i]/R_tr ;
         }
         const double xi1 = R_iC / state.R()[i];
-        const double C0 = (4.0 * M_PI * m::pow<3>(state.h()[i])) / (m::pow<2>(state.GM()));
+        const double C0 = state.Sigma_to_W()[i];
         const double ExP = std::exp(-(((1.0 - (1/std::sqrt(1.0 + 0.25*m::pow<2>(xi1))))*(1.0 - (1/std::sqrt(1.0 + 0.25*m::pow<2>(xi1)))))/(2.0/xi1)));
         C_[i] = -2.0 *(2e42/(state.args().basic->Mx))*(C_0/1e13) * C0 * le * m::pow<2>(xi1) * f_L * g_R * ExP ;		}
     }
@@ -592,13 +711,13 @@ BasicWind(state),
         Xi_max(state.args().disk->windparams.at("Xi_max")),
         T_ic(state.args().disk->windparams.at("T_ic")),
         Pow(state.args().disk->windparams.at("Pow")) {
-    update(state);
+    update(state, state.Mdot_in());
 }
 
-void FreddiState::Woods1996ShieldsApproxWind::update(const FreddiState& state) {
-    BasicWind::update(state);
+void FreddiState::Woods1996ShieldsApproxWind::update(const FreddiState& state, const double Mdot_in) {
+    BasicWind::update(state, Mdot_in);
     const auto disk = state.args().disk;
-    const double L = state.Mdot_in() * m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT) * state.eta();
+    const double L = Mdot_in * m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT) * state.eta();
     const double R_iC = (state.GM() * disk->mu * GSL_CONST_CGSM_MASS_PROTON)/(GSL_CONST_CGSM_BOLTZMANN * T_ic);
     //const double VeL = std::sqrt(state.GM()/R_iC) ;
     //const double C_iC = std::sqrt((GSL_CONST_CGSM_BOLTZMANN * T_ic)/( GSL_CONST_CGSM_MASS_PROTON));
@@ -618,7 +737,7 @@ void FreddiState::Woods1996ShieldsApproxWind::update(const FreddiState& state) {
             const double xi1 = R_iC / state.R()[i];
             const double T_ch = T_ic * std::pow(el, 2.0 / 3.0) * std::pow(xi, -2.0 / 3.0);
             const double C_ch = std::sqrt((GSL_CONST_CGSM_BOLTZMANN * T_ch) / (disk->mu * GSL_CONST_CGSM_MASS_PROTON));
-            const double C0 = (4.0 * M_PI * m::pow<3>(state.h()[i])) / (m::pow<2>(state.GM()));
+            const double C0 = state.Sigma_to_W()[i];
             const double Fr =
                     L / (4.0 * M_PI * m::pow<2>(state.R()[i]) * Xi_max * C_ch * GSL_CONST_CGSM_SPEED_OF_LIGHT);
 //const double Fc = std::pow(((1.0 + ( ((0.125 * el + 0.00382)/ xi) *((0.125 * el + 0.00382)/ xi) ))/( 1 + 1/( (el*el*el*el*(1 + 262.0*xi*xi))*(el*el*el*el*(1 + 262.0*xi*xi)) ) ) ), 1.0/6.0) ;
@@ -639,16 +758,16 @@ void FreddiState::Woods1996ShieldsApproxWind::update(const FreddiState& state) {
 FreddiState::PeriodPaperWind::PeriodPaperWind(const FreddiState& state):
 	BasicWind(state),
 	C_w(state.args().disk->windparams.at("C_w")) {
-    update(state);
+    update(state, state.Mdot_in());
 }
 
-void FreddiState::PeriodPaperWind::update(const FreddiState& state) {
-    BasicWind::update(state);
+void FreddiState::PeriodPaperWind::update(const FreddiState& state, const double Mdot_in) {
+    BasicWind::update(state, Mdot_in);
     const auto disk = state.args().disk;
 
     for (size_t i = state.first(); i <= state.last(); ++i) {
 	//const double C0 = (4.0 * M_PI * m::pow<3>(state.h()[i])) / (m::pow<2>(state.GM()));
-	const double Mdot = state.Mdot_in() * (state.h()[i] - state.h()[state.first()]) /(m::pow<2>(state.h()[state.last()] - state.h()[state.first()])) ;
+	const double Mdot = Mdot_in * (state.h()[i] - state.h()[state.first()]) /(m::pow<2>(state.h()[state.last()] - state.h()[state.first()])) ;
 	C_[i] = - 2.0 * C_w * Mdot;
     }
 }
@@ -716,8 +835,8 @@ double FreddiState::v_cooling_front(double r) {
 
 double FreddiState::R_cooling_front(double r)  {
         // previous location of Rhot moves with the cooling-front velocity:
-        return  R()[last()] - v_cooling_front(r) * args().calc->tau;       
-        //return  R()[last()] - v_cooling_front(R()[last()]) * args().calc->tau  ; 
+        return  R()[last()] - v_cooling_front(r) * tau();       
+        //return  R()[last()] - v_cooling_front(R()[last()]) * tau()  ; 
         // this variant leads to more abrupt evolution, since the front velocity is larger
 }
 
@@ -1,5 +1,9 @@
 #include "nonlinear_diffusion.hpp"
 
+#include <algorithm>  // copy, fill, min
+
+#include "util.hpp"  // ThreadPool
+
 
 double mean_square_rel(const vecd &A, const vecd &B, size_t first, size_t last){
 	double rv = 0;
@@ -26,9 +30,254 @@ double max_dif_rel(const vecd &A, const vecd &B, size_t first, size_t last){
 
 
 
+NonlinearDiffusionSolver::NonlinearDiffusionSolver(const size_t size, const Method method, const size_t anderson_depth,
+													 const unsigned int threads, const size_t parallel_min_size):
+		method(method),
+		anderson_depth(method == Anderson ? anderson_depth : 0),
+		dR(this->anderson_depth),
+		dG(this->anderson_depth),
+		normal(this->anderson_depth * this->anderson_depth),
+		gamma(this->anderson_depth),
+		// hardware_concurrency() returns zero if the number of cores is unknown
+		threads_(std::max(threads, 1u)),
+		parallel_min_size_(parallel_min_size) {
+	reserve(size);
+}
+
+
+void NonlinearDiffusionSolver::reserve(const size_t size) {
+	if (W.size() >= size) {
+		return;
+	}
+	for (auto v : {&W, &W_prev, &dW, &K_0, &K_1, &frac, &a, &b, &c0, &f, &rhs, &alpha, &beta, &y_0}) {
+		v->resize(size, 0.);
+	}
+	if (anderson_depth == 0) {
+		return;
+	}
+	for (auto v : {&weight, &r, &r_prev, &g_prev}) {
+		v->resize(size, 0.);
+	}
+	for (size_t j = 0; j < anderson_depth; ++j) {
+		dR[j].resize(size, 0.);
+		dG[j].resize(size, 0.);
+	}
+}
+
+
+// Tridiagonal matrix algorithm for the linear system with diagonal c0 + K_1 and right-hand side d
+void NonlinearDiffusionSolver::sweep(
+		const vecd& d,
+		const double left_bounder_cond,
+		const double right_bounder_cond,
+		const vecd& x,
+		vecd& y,
+		const size_t first, const size_t last
+) {
+	if (threads_ > 1 && last - first >= parallel_min_size_ && last - first >= 4 * threads_) {
+		partitioned_sweep(d, left_bounder_cond, right_bounder_cond, x, y, first, last);
+		return;
+	}
+	double c;
+	alpha[first + 1] = 0.;
+	beta[first + 1] = left_bounder_cond;
+	for (size_t i = first + 1; i <= last - 1; ++i) {
+		c = c0[i] + K_1[i];
+		alpha[i + 1] = b[i] / (c - alpha[i] * a[i]);
+		beta[i + 1] = (beta[i] * a[i] + d[i]) / (c - alpha[i] * a[i]);
+	}
+	y[last] = ((x[last] - x[last - 1]) * right_bounder_cond + d[last] + beta[last] * a[last]) /
+			   (c0[last] + K_1[last] - alpha[last] * a[last]);
+	for (size_t i = last - 1; i > first; --i) {
+		y[i] = alpha[i + 1] * y[i + 1] + beta[i + 1];
+	}
+	y[first] = left_bounder_cond;
+}
+
+
+// The same system is split into chunks by separator points p_k, p_0 = first, p_K = last. Inside the chunk k forward
+// sweep gives y_i = alpha_{i+1} y_{i+1} + beta_{i+1} + zeta_{i+1} y(p_{k-1}), and backward recursion expresses
+// the first chunk point as a linear function of both separator values. Substitution of them to the separator
+// equations gives tridiagonal system of size K, which is solved serially. Forward and backward passes over chunks
+// are done in parallel
+void NonlinearDiffusionSolver::partitioned_sweep(
+		const vecd& d,
+		const double left_bounder_cond,
+		const double right_bounder_cond,
+		const vecd& x,
+		vecd& y,
+		const size_t first, const size_t last
+) {
+	if (!pool || pool->threads() != threads_) {
+		pool = std::make_shared<ThreadPool>(threads_);
+	}
+	const size_t K = threads_;
+	if (zeta.size() < W.size()) {
+		zeta.resize(W.size(), 0.);
+	}
+	for (auto v : {&start_u, &start_v, &start_w, &reduced_alpha, &reduced_beta, &separator}) {
+		v->resize(K + 1, 0.);
+	}
+	separator_index.resize(K + 1);
+	for (size_t k = 0; k <= K; ++k) {
+		separator_index[k] = first + (last - first) * k / K;
+	}
+
+	pool->run(K, [&](const size_t chunk) {
+		const size_t begin = separator_index[chunk];
+		const size_t end = separator_index[chunk + 1];
+		alpha[begin + 1] = 0.;
+		beta[begin + 1] = 0.;
+		zeta[begin + 1] = 1.;
+		for (size_t i = begin + 1; i <= end - 1; ++i) {
+			const double den = c0[i] + K_1[i] - alpha[i] * a[i];
+			alpha[i + 1] = b[i] / den;
+			beta[i + 1] = (beta[i] * a[i] + d[i]) / den;
+			zeta[i + 1] = zeta[i] * a[i] / den;
+		}
+		// y_{begin+1} = u + v y(begin) + w y(end)
+		double u = beta[end], v = zeta[end], w = alpha[end];
+		for (size_t i = end - 1; i > begin + 1; --i) {
+			u = alpha[i] * u + beta[i];
+			v = alpha[i] * v + zeta[i];
+			w = alpha[i] * w;
+		}
+		start_u[chunk] = u;
+		start_v[chunk] = v;
+		start_w[chunk] = w;
+	});
+
+	// Reduced system: Thomas algorithm over separator values, Y_0 is known
+	reduced_alpha[1] = 0.;
+	reduced_beta[1] = left_bounder_cond;
+	for (size_t k = 1; k < K; ++k) {
+		const size_t p = separator_index[k];
+		const double c = c0[p] + K_1[p] - a[p] * alpha[p] - b[p] * start_v[k];
+		const double a_k = a[p] * zeta[p];
+		const double b_k = b[p] * start_w[k];
+		const double d_k = d[p] + a[p] * beta[p] + b[p] * start_u[k];
+		reduced_alpha[k + 1] = b_k / (c - reduced_alpha[k] * a_k);
+		reduced_beta[k + 1] = (reduced_beta[k] * a_k + d_k) / (c - reduced_alpha[k] * a_k);
+	}
+	{
+		const double c = c0[last] + K_1[last] - a[last] * alpha[last];
+		const double a_K = a[last] * zeta[last];
+		const double d_K = (x[last] - x[last - 1]) * right_bounder_cond + d[last] + a[last] * beta[last];
+		separator[K] = (d_K + reduced_beta[K] * a_K) / (c - reduced_alpha[K] * a_K);
+	}
+	for (size_t k = K - 1; k > 0; --k) {
+		separator[k] = reduced_alpha[k + 1] * separator[k + 1] + reduced_beta[k + 1];
+	}
+	separator[0] = left_bounder_cond;
+
+	pool->run(K, [&](const size_t chunk) {
+		const size_t begin = separator_index[chunk];
+		const size_t end = separator_index[chunk + 1];
+		const double y_begin = separator[chunk];
+		y[end] = separator[chunk + 1];
+		for (size_t i = end - 1; i > begin; --i) {
+			y[i] = alpha[i + 1] * y[i + 1] + beta[i + 1] + zeta[i + 1] * y_begin;
+		}
+	});
+	y[first] = left_bounder_cond;
+}
+
+
+// Replaces K_1 = g(K_0) with the Anderson mixture of the last fixed-point map values: K_1 = g(K_0) - dG gamma,
+// where gamma minimises the weighted norm of the residual |r - dR gamma|, r = g(K_0) - K_0
+void NonlinearDiffusionSolver::anderson_mix(const size_t first, const size_t last) {
+	if (anderson_depth == 0) {
+		return;
+	}
+	for (size_t i = first; i <= last; ++i) {
+		r[i] = (K_1[i] - K_0[i]) * weight[i];
+	}
+	if (iterations_ > 1) {
+		auto& dr = dR[history_next];
+		auto& dg = dG[history_next];
+		for (size_t i = first; i <= last; ++i) {
+			dr[i] = r[i] - r_prev[i];
+			dg[i] = K_1[i] - g_prev[i];
+		}
+		history_next = (history_next + 1) % anderson_depth;
+		history_size = std::min(history_size + 1, anderson_depth);
+	}
+	std::copy(r.begin() + first, r.begin() + last + 1, r_prev.begin() + first);
+	std::copy(K_1.begin() + first, K_1.begin() + last + 1, g_prev.begin() + first);
+	if (history_size == 0) {
+		return;
+	}
+
+	// Normal equations dR^T dR gamma = dR^T r, solved by Gaussian elimination with partial pivoting
+	const size_t m = history_size;
+	for (size_t j = 0; j < m; ++j) {
+		for (size_t k = j; k < m; ++k) {
+			double sum = 0.;
+			for (size_t i = first; i <= last; ++i) {
+				sum += dR[j][i] * dR[k][i];
+			}
+			normal[j * m + k] = normal[k * m + j] = sum;
+		}
+		double sum = 0.;
+		for (size_t i = first; i <= last; ++i) {
+			sum += dR[j][i] * r[i];
+		}
+		gamma[j] = sum;
+	}
+	double max_diagonal = 0.;
+	for (size_t j = 0; j < m; ++j) {
+		max_diagonal = std::max(max_diagonal, normal[j * m + j]);
+	}
+	for (size_t j = 0; j < m; ++j) {
+		size_t pivot = j;
+		for (size_t k = j + 1; k < m; ++k) {
+			if (std::abs(normal[k * m + j]) > std::abs(normal[pivot * m + j])) {
+				pivot = k;
+			}
+		}
+		// Degenerated history, restart it and make simple fixed-point step
+		if (!(std::abs(normal[pivot * m + j]) > 1e-14 * max_diagonal)) {
+			history_size = 0;
+			return;
+		}
+		if (pivot != j) {
+			for (size_t k = 0; k < m; ++k) {
+				std::swap(normal[j * m + k], normal[pivot * m + k]);
+			}
+			std::swap(gamma[j], gamma[pivot]);
+		}
+		for (size_t k = j + 1; k < m; ++k) {
+			const double factor = normal[k * m + j] / normal[j * m + j];
+			for (size_t l = j; l < m; ++l) {
+				normal[k * m + l] -= factor * normal[j * m + l];
+			}
+			gamma[k] -= factor * gamma[j];
+		}
+	}
+	for (size_t j = m; j-- > 0;) {
+		for (size_t k = j + 1; k < m; ++k) {
+			gamma[j] -= normal[j * m + k] * gamma[k];
+		}
+		gamma[j] /= normal[j * m + j];
+	}
+
+	for (size_t i = first; i <= last; ++i) {
+		for (size_t j = 0; j < m; ++j) {
+			K_1[i] -= gamma[j] * dG[j][i];
+		}
+		// Mixture is not allowed to change sign of K, fall back to simple fixed-point step
+		if (!(K_1[i] * g_prev[i] > 0.)) {
+			std::copy(g_prev.begin() + first, g_prev.begin() + last + 1, K_1.begin() + first);
+			history_size = 0;
+			return;
+		}
+	}
+}
+
+
 // \frac{dw}{dt}=\frac{d^2y}{dx^2} + A\frac{dy}{dx} + By + C, y=y(x,t) — ?, w = w (x,y)
 
-void nonlinear_diffusion_nonuniform_wind_1_2 (
+void NonlinearDiffusionSolver::operator()(
 		const double tau,
 		const double eps, // relative error for w
 		const double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
@@ -36,54 +285,254 @@ void nonlinear_diffusion_nonuniform_wind_1_2 (
 		const vecd &A,
 		const vecd &B,
 		const vecd &C,
-		const std::function<vecd (const vecd &, const vecd &, size_t, size_t)>& wunc, // first argument is array of x_i, second — array of y(x_i,t); return value — array of w(x_i,y_i)
+		const wunc_t& wunc, // first argument is array of x_i, second — array of y(x_i,t), third — array of w(x_i,y_i)
+		const dwunc_t& dwunc, // the same as wunc, but the fourth argument is array of dw/dy(x_i,y_i)
 		const vecd &x, // array with (non)uniform grid
 		vecd &y, // array with initial condition and for results
-		size_t first, size_t last // indexes of front and back elements
+		size_t first, size_t last, // indexes of front and back elements
+		const double tau_prev, // previous time step, BDF2 scheme is used if it is positive
+		const vecd &y_prev, // array with solution on the previous time moment, used by BDF2 only
+		const vecd &y_guess // initial approximation of the solution, y is used if it is empty
 ) {
-	auto W = wunc(x, y, first + 1, last);
-	vecd K_0(last + 1), K_1(last + 1), frac(last + 1), a(last + 1), b(last + 1), c0(last + 1), f(last + 1);
-	for (size_t i = first + 1; i <= last - 1; ++i) {
-		a[i] = (x[i + 1] - x[i]) / (x[i + 1] - x[i - 1]) * (2.0 - A[i] * (x[i + 1] - x[i]));
-		b[i] = (x[i] - x[i - 1]) / (x[i + 1] - x[i - 1]) * (2.0 + A[i] * (x[i] - x[i - 1]));
-		c0[i] = 2.0 - A[i] * (x[i + 1] - 2 * x[i] + x[i - 1]) - B[i] * (x[i + 1] - x[i]) * (x[i] - x[i - 1]);
-		frac[i] = (x[i + 1] - x[i]) * (x[i] - x[i - 1]) / tau;
-	}
-	a[last] = 1 - 0.5 * A[last] * (x[last] - x[last - 1]);
-	c0[last] = a[last] - 0.5 * B[last] * (x[last] - x[last - 1]) * (x[last] - x[last - 1]);
-	frac[last] = (x[last] - x[last - 1]) * (x[last] - x[last - 1]) * 0.5 / tau;
-	for (size_t i = first + 1; i <= last; ++i) {
-		f[i] = frac[i] * (W[i] + tau * C[i]);
+	reserve(last + 1);
+	wunc(x, y, W, first + 1, last);
+	// BDF2 has the same form as backward Euler with effective time step tau_eff and known part of w replaced by
+	// a combination of w on two previous time moments:
+	// w^{n+1} - [(1+omega)^2 w^n - omega^2 w^{n-1}] / (1+2omega) = tau_eff L(y^{n+1}), omega = tau / tau_prev
+	const bool bdf2 = tau_prev > 0.;
+	double tau_eff = tau;
+	if (bdf2) {
+		const double omega = tau / tau_prev;
+		tau_eff = tau * (1. + omega) / (1. + 2. * omega);
+		wunc(x, y_prev, W_prev, first + 1, last);
+		for (size_t i = first + 1; i <= last; ++i) {
+			W_prev[i] = ((1. + omega) * (1. + omega) * W[i] - omega * omega * W_prev[i]) / (1. + 2. * omega);
+		}
 	}
-	for (size_t i = first + 1; i <= last - 1; ++i) {
-//		K_1[i] = (f[i] + a[i] * y[i - 1] - c0[i] * y[i] + b[i] * y[i + 1]) / y[i];
-//		K_1[i] = frac[i] * W[i] / y[i];
-		K_1[i] = f[i] / y[i];
+	const vecd& W_known = bdf2 ? W_prev : W;
+	if (coefficients_x != x.data() || coefficients_first != first || coefficients_last != last || coefficients_tau != tau_eff) {
+		for (size_t i = first + 1; i <= last - 1; ++i) {
+			a[i] = (x[i + 1] - x[i]) / (x[i + 1] - x[i - 1]) * (2.0 - A[i] * (x[i + 1] - x[i]));
+			b[i] = (x[i] - x[i - 1]) / (x[i + 1] - x[i - 1]) * (2.0 + A[i] * (x[i] - x[i - 1]));
+			c0[i] = 2.0 - A[i] * (x[i + 1] - 2 * x[i] + x[i - 1]) - B[i] * (x[i + 1] - x[i]) * (x[i] - x[i - 1]);
+			frac[i] = (x[i + 1] - x[i]) * (x[i] - x[i - 1]) / tau_eff;
+		}
+		a[last] = 1 - 0.5 * A[last] * (x[last] - x[last - 1]);
+		c0[last] = a[last] - 0.5 * B[last] * (x[last] - x[last - 1]) * (x[last] - x[last - 1]);
+		frac[last] = (x[last] - x[last - 1]) * (x[last] - x[last - 1]) * 0.5 / tau_eff;
+		coefficients_x = x.data();
+		coefficients_first = first;
+		coefficients_last = last;
+		coefficients_tau = tau_eff;
+	}
+	for (size_t i = first + 1; i <= last; ++i) {
+		f[i] = frac[i] * (W_known[i] + tau_eff * C[i]);
 	}
 //	K_1[last] = (f[last] + a[last] * y[last - 1] - c0[last] * y[last] + right_bounder_cond * (x[last] - x[last - 1])) / y[last];
 //	K_1[last] = (f[last]) / y[last];
 	K_1[last] = frac[last] * W[last] / y[last];
+	const bool guess = !y_guess.empty();
 
-	vecd alpha(last + 1), beta(last + 1);
-	double c;
+	iterations_ = 0;
+	if (method == Newton) {
+		// Outer row is kept linear with K_1[last] fixed, so it is the same as for Picard iterations
+		rhs[last] = f[last];
+		if (guess) {
+			std::copy(y_guess.begin() + first + 1, y_guess.begin() + last + 1, y.begin() + first + 1);
+			wunc(x, y, W, first + 1, last);
+		}
+		do {
+			std::copy(y.begin() + first + 1, y.begin() + last + 1, y_0.begin() + first + 1);
+			dwunc(x, y, W, dW, first + 1, last - 1);
+			for (size_t i = first + 1; i <= last - 1; ++i) {
+				K_1[i] = frac[i] * dW[i];
+				rhs[i] = f[i] + frac[i] * (dW[i] * y[i] - W[i]);
+			}
+			sweep(rhs, left_bounder_cond, right_bounder_cond, x, y, first, last);
+			wunc(x, y, W, first + 1, last);
+			++iterations_;
+			residual_ = max_dif_rel(y, y_0, first + 1, last);
+		} while (residual_ > eps);
+		return;
+	}
+
+	if (guess) {
+		// Fixed-point map of the initial guess
+		wunc(x, y_guess, W, first + 1, last - 1);
+		for (size_t i = first + 1; i <= last - 1; ++i) {
+			K_1[i] = frac[i] * W[i] / y_guess[i];
+		}
+	} else {
+		for (size_t i = first + 1; i <= last - 1; ++i) {
+//			K_1[i] = (f[i] + a[i] * y[i - 1] - c0[i] * y[i] + b[i] * y[i + 1]) / y[i];
+//			K_1[i] = frac[i] * W[i] / y[i];
+			K_1[i] = f[i] / y[i];
+		}
+	}
+	if (method == Anderson) {
+		// Residuals are relative to the initial K to make all grid points equally important
+		for (size_t i = first + 1; i <= last - 1; ++i) {
+			weight[i] = 1. / std::abs(K_1[i]);
+		}
+		history_size = 0;
+		history_next = 0;
+	}
 	do {
-		K_0 = K_1;
-		alpha[first + 1] = 0.;
-		beta[first + 1] = left_bounder_cond;
+		std::copy(K_1.begin() + first + 1, K_1.begin() + last + 1, K_0.begin() + first + 1);
+		sweep(f, left_bounder_cond, right_bounder_cond, x, y, first, last);
+		wunc(x, y, W, first + 1, last);
 		for (size_t i = first + 1; i <= last - 1; ++i) {
-			c = c0[i] + K_1[i];
-			alpha[i + 1] = b[i] / (c - alpha[i] * a[i]);
-			beta[i + 1] = (beta[i] * a[i] + f[i]) / (c - alpha[i] * a[i]);
-		}
-		y[last] = ((x[last] - x[last - 1]) * right_bounder_cond + f[last] + beta[last] * a[last]) /
-				   (c0[last] + K_1[last] - alpha[last] * a[last]);
-		for (size_t i = last - 1; i > first; --i) {
-			y[i] = alpha[i + 1] * y[i + 1] + beta[i + 1];
-		}
-		y[first] = left_bounder_cond;
-		W = wunc(x, y, first + 1, last);
-		for (size_t i = 1; i <= last - 1; ++i) {
 			K_1[i] = frac[i] * W[i] / y[i];
 		}
-	} while (max_dif_rel(K_1, K_0, 1, last - 1) > eps);
+		++iterations_;
+		residual_ = max_dif_rel(K_1, K_0, first + 1, last - 1);
+		if (method == Anderson && residual_ > eps) {
+			anderson_mix(first + 1, last - 1);
+		}
+	} while (residual_ > eps);
+}
+
+
+BatchNonlinearDiffusionSolver::BatchNonlinearDiffusionSolver(const size_t lanes, const size_t size):
+		lanes_(lanes),
+		active(lanes),
+		iterations_(lanes),
+		residual_(lanes) {
+	reserve(size);
+}
+
+
+void BatchNonlinearDiffusionSolver::reserve(const size_t size) {
+	if (W.size() >= size * lanes_) {
+		return;
+	}
+	for (auto v : {&W, &K_0, &K_1, &frac, &a, &b, &c0, &f, &alpha, &beta}) {
+		v->resize(size * lanes_, 0.);
+	}
+}
+
+
+// The same tridiagonal matrix algorithm as NonlinearDiffusionSolver::sweep with right-hand side f
+void BatchNonlinearDiffusionSolver::sweep(
+		const vecd& left_bounder_cond,
+		const vecd& right_bounder_cond,
+		const vecd& x,
+		vecd& y,
+		const size_t first, const size_t last
+) {
+	const size_t L = lanes_;
+	for (size_t l = 0; l < L; ++l) {
+		alpha[(first + 1) * L + l] = 0.;
+		beta[(first + 1) * L + l] = left_bounder_cond[l];
+	}
+	for (size_t i = first + 1; i <= last - 1; ++i) {
+		for (size_t l = 0; l < L; ++l) {
+			const size_t j = i * L + l;
+			const double c = c0[j] + K_1[j];
+			alpha[j + L] = b[j] / (c - alpha[j] * a[j]);
+			beta[j + L] = (beta[j] * a[j] + f[j]) / (c - alpha[j] * a[j]);
+		}
+	}
+	for (size_t l = 0; l < L; ++l) {
+		const size_t j = last * L + l;
+		y[j] = ((x[j] - x[j - L]) * right_bounder_cond[l] + f[j] + beta[j] * a[j]) /
+			   (c0[j] + K_1[j] - alpha[j] * a[j]);
+	}
+	for (size_t i = last - 1; i > first; --i) {
+		for (size_t l = 0; l < L; ++l) {
+			const size_t j = i * L + l;
+			y[j] = alpha[j + L] * y[j + L] + beta[j + L];
+		}
+	}
+	for (size_t l = 0; l < L; ++l) {
+		y[first * L + l] = left_bounder_cond[l];
+	}
+}
+
+
+void BatchNonlinearDiffusionSolver::operator()(
+		const vecd &tau,
+		const vecd &eps,
+		const vecd &left_bounder_cond,
+		const vecd &right_bounder_cond,
+		const vecd &A,
+		const vecd &B,
+		const vecd &C,
+		const wunc_t& wunc,
+		const vecd &x,
+		vecd &y,
+		const size_t first, const size_t last
+) {
+	const size_t L = lanes_;
+	reserve(last + 1);
+	wunc(x, y, W, first + 1, last);
+	for (size_t i = first + 1; i <= last - 1; ++i) {
+		for (size_t l = 0; l < L; ++l) {
+			const size_t j = i * L + l;
+			a[j] = (x[j + L] - x[j]) / (x[j + L] - x[j - L]) * (2.0 - A[j] * (x[j + L] - x[j]));
+			b[j] = (x[j] - x[j - L]) / (x[j + L] - x[j - L]) * (2.0 + A[j] * (x[j] - x[j - L]));
+			c0[j] = 2.0 - A[j] * (x[j + L] - 2 * x[j] + x[j - L]) - B[j] * (x[j + L] - x[j]) * (x[j] - x[j - L]);
+			frac[j] = (x[j + L] - x[j]) * (x[j] - x[j - L]) / tau[l];
+		}
+	}
+	for (size_t l = 0; l < L; ++l) {
+		const size_t j = last * L + l;
+		a[j] = 1 - 0.5 * A[j] * (x[j] - x[j - L]);
+		c0[j] = a[j] - 0.5 * B[j] * (x[j] - x[j - L]) * (x[j] - x[j - L]);
+		frac[j] = (x[j] - x[j - L]) * (x[j] - x[j - L]) * 0.5 / tau[l];
+	}
+	for (size_t i = first + 1; i <= last; ++i) {
+		for (size_t l = 0; l < L; ++l) {
+			const size_t j = i * L + l;
+			f[j] = frac[j] * (W[j] + tau[l] * C[j]);
+		}
+	}
+	for (size_t l = 0; l < L; ++l) {
+		const size_t j = last * L + l;
+		K_1[j] = frac[j] * W[j] / y[j];
+	}
+	for (size_t j = (first + 1) * L; j < last * L; ++j) {
+		K_1[j] = f[j] / y[j];
+	}
+
+	std::fill(active.begin(), active.end(), 1);
+	std::fill(iterations_.begin(), iterations_.end(), 0);
+	size_t n_active = L;
+	while (n_active > 0) {
+		std::copy(K_1.begin() + (first + 1) * L, K_1.begin() + (last + 1) * L, K_0.begin() + (first + 1) * L);
+		sweep(left_bounder_cond, right_bounder_cond, x, y, first, last);
+		wunc(x, y, W, first + 1, last);
+		for (size_t l = 0; l < L; ++l) {
+			residual_[l] = active[l] ? 0. : residual_[l];
+		}
+		for (size_t i = first + 1; i <= last - 1; ++i) {
+			for (size_t l = 0; l < L; ++l) {
+				const size_t j = i * L + l;
+				K_1[j] = active[l] ? frac[j] * W[j] / y[j] : K_0[j];
+				const double dif = std::abs((K_1[j] - K_0[j]) / K_1[j]);
+				residual_[l] = dif > residual_[l] ? dif : residual_[l];
+			}
+		}
+		n_active = 0;
+		for (size_t l = 0; l < L; ++l) {
+			if (!active[l]) {
+				continue;
+			}
+			++iterations_[l];
+			if (residual_[l] > eps[l]) {
+				++n_active;
+			} else {
+				active[l] = 0;
+			}
+		}
+		// Converged lanes keep K used by the last sweep, so their solution doesn't change any more
+		if (n_active < L) {
+			for (size_t i = first + 1; i <= last - 1; ++i) {
+				for (size_t l = 0; l < L; ++l) {
+					const size_t j = i * L + l;
+					K_1[j] = active[l] ? K_1[j] : K_0[j];
+				}
+			}
+		}
+	}
 }
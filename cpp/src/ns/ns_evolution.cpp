@@ -469,16 +469,23 @@ double FreddiNeutronStarEvolution::Lx_ns_rest_frame() {
 	if (!ns_opt_str_.Lx_ns_rest_frame) {
 		const double nu_min = args().flux->emin / redshift();
 		const double nu_max = args().flux->emax / redshift();
-		const double intensity = Spectrum::Planck_nu1_nu2(T_hot_spot(), nu_min, nu_max, 1e-4);
+		const double intensity = Spectrum::Planck_nu1_nu2(T_hot_spot(), nu_min, nu_max);
 		ns_opt_str_.Lx_ns_rest_frame = 4*M_PI * hot_spot_area() * m::pow<2>(R_x()) * M_PI * intensity;
 	}
 	return *ns_opt_str_.Lx_ns_rest_frame;
 }
 
 
-void FreddiNeutronStarEvolution::invalidate_optional_structure() {
-	FreddiEvolution::invalidate_optional_structure();
-	ns_opt_str_ = NeutronStarOptionalStructure();
+void FreddiNeutronStarEvolution::invalidate_optional_structure(const unsigned int changed) {
+	FreddiEvolution::invalidate_optional_structure(changed);
+	ns_opt_str_.invalidate(changed);
+}
+
+
+// Magnetic torque arrays depend on the grid, so they are recalculated for the new one
+void FreddiNeutronStarEvolution::remesh(const double h_hot) {
+	FreddiEvolution::remesh(h_hot);
+	ns_str_.reset(new NeutronStarStructure(ns_str_->args_ns, this));
 }
 
 
@@ -804,29 +811,27 @@ IrradiatedStar::sources_t FreddiNeutronStarEvolution::star_irr_sources() {
 }
 
 
-vecd FreddiNeutronStarEvolution::windC() const {
-	auto C = FreddiEvolution::windC();
-	for (size_t i = 0; i < C.size(); i++) {
-		C[i] += d2Fmagn_dh2()[i];
+// Magnetic torque of the neutron star is the source term of the diffusion equation added to the wind one
+const vecd& FreddiNeutronStarEvolution::windC() {
+	if (!ns_opt_str_.windC_valid) {
+		const vecd& C_wind = FreddiEvolution::windC();
+		vecd& C = ns_opt_str_.windC;
+		C.resize(C_wind.size());
+		for (size_t i = 0; i < C.size(); i++) {
+			C[i] = C_wind[i] + d2Fmagn_dh2()[i];
+		}
+		ns_opt_str_.windC_valid = true;
 	}
-	return C;
+	return ns_opt_str_.windC;
 }
 
 
-const vecd& FreddiNeutronStarEvolution::Qx() {
-	if (!opt_str_.Qx) {
-		vecd x(Nx());
-		const vecd& K = Kirr();
-		const vecd& H = Height();
-		const double L_disk = Lbol_disk();
-		const double L_ns = Lbol_ns();
-		for (size_t i = first(); i < Nx(); i++) {
-			const double mu = H[i] / R()[i];
-			x[i] = K[i] * (L_disk * angular_dist_disk(mu) + L_ns * angular_dist_ns(mu)) / (4. * M_PI * m::pow<2>(R()[i]));
-		}
-		opt_str_.Qx = std::move(x);
-	}
-	return *opt_str_.Qx;
+std::function<double (double)> FreddiNeutronStarEvolution::irradiating_luminosity() const {
+	const double L_disk = Lbol_disk();
+	const double L_ns = Lbol_ns();
+	return [this, L_disk, L_ns](const double mu) -> double {
+		return L_disk * angular_dist_disk(mu) + L_ns * angular_dist_ns(mu);
+	};
 }
 
 /*
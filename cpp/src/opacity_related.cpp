@@ -25,8 +25,9 @@ OpacityRelated::OpacityRelated(
 
 
 void OpacityRelated::init_Kramers(){
-	m = 0.3;
-	n = 0.8;
+	kind = Kramers;
+	m = KramersOpacity::m;
+	n = KramersOpacity::n;
 	varkappa0 = 5e24;
 
 	// tau_0 = 1e3
@@ -54,8 +55,9 @@ void OpacityRelated::init_Kramers(){
 
 
 void OpacityRelated::init_OPAL(){
-	m = 1./3.;
-	n = 1.;
+	kind = OPAL;
+	m = OPALOpacity::m;
+	n = OPALOpacity::n;
 	varkappa0 = 1.5e20;
 
 	// tau_0 = 1e3
@@ -83,7 +85,7 @@ void OpacityRelated::init_OPAL(){
 
 
 double OpacityRelated::Height(double R, double F) const {
-	return R * Height_coef * pow(F, Height_exp_F) * pow(R/1e10, Height_exp_R - Height_exp_F/2.);
+	return dispatch([this, R, F](auto opacity) { return Height(opacity, R, F); });
 }
 
 
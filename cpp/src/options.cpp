@@ -15,7 +15,8 @@ GeneralOptions::GeneralOptions(const po::variables_map& vm):
 				vm["precision"].as<unsigned int>(),
 				vm["tempsparsity"].as<unsigned int>(),
 				(vm.count("fulldata") > 0),
-				(vm.count("stdout") > 0)) {}
+				(vm.count("stdout") > 0),
+				(vm.count("solverstats") > 0)) {}
 
 po::options_description GeneralOptions::description() {
 	po::options_description od("General options:");
@@ -28,6 +29,7 @@ po::options_description GeneralOptions::description() {
 			( "precision", po::value<unsigned int>()->default_value(default_output_precision), "Number of digits to print into output files\n" )
 			( "tempsparsity", po::value<unsigned int>()->default_value(default_temp_sparsity_output), "Output every k-th time moment\n" )
 			( "fulldata", "Output files PREFIX_%d.dat with radial structure for every time step. Default is to output only PREFIX.dat with global disk parameters for every time step\n" )
+			( "solverstats", "Add columns with the number of iterations and the final relative residual of the non-linear solver for every time step into PREFIX.dat\n" )
 			;
 	return od;
 }
@@ -347,10 +349,41 @@ CalculationOptions::CalculationOptions(const po::variables_map &vm):
 				tauInitializer(vm),
 				vm["Nx"].as<unsigned int>(),
 				vm["gridscale"].as<std::string>(),
-				vm["starlod"].as<unsigned int>()) {
+				vm["starlod"].as<unsigned int>(),
+				default_eps,
+				vm["nonlinearsolver"].as<std::string>(),
+				vm["andersondepth"].as<unsigned int>(),
+				vm.count("adaptivetau") > 0,
+				vm["taurtol"].as<double>(),
+				daysInitializer(vm, "taumin"),
+				daysInitializer(vm, "taumax"),
+				vm["timescheme"].as<std::string>(),
+				vm.count("remesh") > 0,
+				vm["remeshrefine"].as<double>(),
+				vm.count("movingboundary") > 0,
+				vm.count("predictor") > 0,
+				vm["windcoupling"].as<std::string>()) {
 	if (gridscale != "log" && gridscale != "linear") {
 		throw po::invalid_option_value("Invalid --gridscale value");
 	}
+	if (nonlinear_solver != "picard" && nonlinear_solver != "newton" && nonlinear_solver != "anderson") {
+		throw po::invalid_option_value("Invalid --nonlinearsolver value");
+	}
+	if (time_scheme != "euler" && time_scheme != "bdf2") {
+		throw po::invalid_option_value("Invalid --timescheme value");
+	}
+	if (wind_coupling != "explicit" && wind_coupling != "implicit") {
+		throw po::invalid_option_value("Invalid --windcoupling value");
+	}
+	if (tau_rtol <= 0.) {
+		throw po::invalid_option_value("--taurtol should be positive");
+	}
+	if (tau_min <= 0. || tau_min > tau_max) {
+		throw po::invalid_option_value("--taumin should be positive and not larger than --taumax");
+	}
+	if (remesh_refine < 0.) {
+		throw po::invalid_option_value("--remeshrefine should be non-negative");
+	}
 }
 
 std::optional<double> CalculationOptions::tauInitializer(const po::variables_map& vm) {
@@ -360,15 +393,34 @@ std::optional<double> CalculationOptions::tauInitializer(const po::variables_map
 	return {};
 }
 
+std::optional<double> CalculationOptions::daysInitializer(const po::variables_map& vm, const std::string& name) {
+	if (vm.count(name)) {
+		return dayToS(vm[name].as<double>());
+	}
+	return {};
+}
+
 po::options_description CalculationOptions::description() {
 	po::options_description od("Parameters of disk evolution calculation:\n");
 	od.add_options()
 			("inittime", po::value<double>()->default_value(default_init_time), "Initial time moment, days\n" )
 			( "time,T", po::value<double>()->required(), "Time interval to calculate evolution, days\n" )
-			( "tau",	po::value<double>(), "Time step, days\n" )
+			( "tau",	po::value<double>(), "Time step, days. With --adaptivetau it is the interval between output time moments\n" )
 			( "Nx",	po::value<unsigned int>()->default_value(default_Nx), "Size of calculation grid\n" )
 			( "gridscale", po::value<std::string>()->default_value(default_gridscale), "Type of grid for angular momentum h: log or linear\n" )
 			( "starlod", po::value<unsigned int>()->default_value(default_starlod), "Level of detail of the optical star 3-D model. The optical star is represented by a triangular tile, the number of tiles is 20 * 4^starlod\n" )
+			( "nonlinearsolver", po::value<std::string>()->default_value(default_nonlinear_solver), "Method to solve non-linear equation for viscous torque on every time step: picard or newton or anderson. picard is a simple fixed-point iteration, newton uses Newton-Raphson iterations with analytical Jacobian, it converges faster for large time steps, anderson is the fixed-point iteration with Anderson acceleration\n" )
+			( "andersondepth", po::value<unsigned int>()->default_value(default_anderson_depth), "Number of previous iterations used by Anderson acceleration, works only with --nonlinearsolver=anderson\n" )
+			( "predictor", "Start non-linear iterations of every time step from the viscous torque extrapolated from two or three previous time moments instead of the current one. It decreases the number of iterations for smooth evolution, the current viscous torque is used if the disk boundaries or the grid are changed\n" )
+			( "timescheme", po::value<std::string>()->default_value(default_time_scheme), "Implicit scheme of time integration: euler or bdf2. euler is the first-order backward Euler scheme, bdf2 is the second-order backward differentiation formula, it allows larger time steps for the same accuracy\n" )
+			( "windcoupling", po::value<std::string>()->default_value(default_wind_coupling), "Coupling of time-dependent wind and disk evolution: explicit or implicit. explicit uses wind calculated for the accretion rate on the beginning of every time step, implicit iterates the accretion rate on the end of the step and the wind calculated for it until they are consistent, it allows larger time steps if wind is strong\n" )
+			( "adaptivetau", "Split every time step into smaller steps, their size is chosen automatically to keep local truncation error of viscous torque below --taurtol\n" )
+			( "taurtol", po::value<double>()->default_value(default_tau_rtol), "Relative tolerance for local truncation error of viscous torque, works only with --adaptivetau\n" )
+			( "taumin", po::value<double>(), "Minimum time step, days. Default is 0.001 * tau, works only with --adaptivetau\n" )
+			( "taumax", po::value<double>(), "Maximum time step, days. Default is tau, works only with --adaptivetau\n" )
+			( "remesh", "Move grid points between time steps to resolve the outer boundary of the hot disk. Grid points are redistributed when the disk boundaries move, viscous torque is remapped conserving the mass of the hot disk. Several times smaller --Nx is required for the same accuracy\n" )
+			( "remeshrefine", po::value<double>()->default_value(default_remesh_refine), "Maximum increase of grid point density near the outer boundary of the hot disk relative to the --gridscale grid, works only with --remesh\n" )
+			( "movingboundary", "Track the outer radius of the hot disk continuously instead of moving it by whole grid points. The outer boundary point is placed where the cooling front or the --boundcond temperature condition is crossed, the position is linearly interpolated between grid points. It gives smooth Rhot and light curves on coarse grids, works only with --remesh\n" )
 			;
 	return od;
 }
@@ -221,14 +221,14 @@ std::vector<FileOutputShortField> FreddiFileOutput::initializeShortFields(const
 				std::string("Fnu") + std::to_string(i),
 				"erg/s/cm^2/Hz",
 				"Spectral flux density of the hot disk at wavelength of " + std::to_string(cmToAngstrom(lambda)) + " AA",
-				[freddi, lambda]() { return freddi->flux(lambda); }
+				[freddi, i]() { return freddi->fluxes()[i]; }
 		);
 		if (cold_disk) {
 			fields.emplace_back(
 					std::string("Fnu") + std::to_string(i) + "_cold",
 					"erg/s/cm^2/Hz",
 					"Spectral flux density of the cold disk at wavelength of " + std::to_string(cmToAngstrom(lambda)) + " AA",
-					[freddi, lambda]() { return freddi->flux_region<FreddiState::ColdRegion>(lambda); }
+					[freddi, i]() { return freddi->fluxes_region<FreddiState::ColdRegion>()[i]; }
 			);
 		}
 		if (star) {
@@ -288,6 +288,14 @@ std::vector<FileOutputShortField> FreddiFileOutput::initializeShortFields(const
 			);
 		}
 	}
+	if (freddi->args().general->solver_stats) {
+		fields.emplace_back("Niter", "int", "Number of iterations of the non-linear solver made on the last time step", [freddi]() { return freddi->nonlinear_iterations(); });
+		fields.emplace_back("residual", "float", "Relative difference of the last two iterations of the non-linear solver", [freddi]() { return freddi->nonlinear_residual(); });
+		if (freddi->args().calc->adaptive_tau) {
+			fields.emplace_back("Nsteps", "int", "Number of adaptive time steps made since the previous time moment", [freddi]() { return freddi->substeps(); });
+			fields.emplace_back("tau", "days", "Size of the last adaptive time step", [freddi]() { return sToDay(freddi->tau()); });
+		}
+	}
 	return fields;
 }
 
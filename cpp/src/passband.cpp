@@ -1,4 +1,6 @@
 #include <fstream> // ifstream
+#include <algorithm> // min, max
+#include <cmath> // exp, expm1, log
 #include <exception> // logic_error
 
 #include <boost/filesystem.hpp> // path
@@ -67,10 +69,74 @@ std::function<double (size_t)> EnergyPassband::widthFrequencyIntegrationFunction
 	};
 }
 
-double EnergyPassband::bb_integral(const double temp) const {
-	return trapz(lambdas, [this, temp](const size_t i) -> double {
-		return transmissions[i] * Spectrum::Planck_lambda(temp, lambdas[i]);
+double EnergyPassband::bbIntegral(const vecd& lambdas, const vecd& transmissions, const double temp) {
+	vecd B(lambdas.size());
+	Spectrum::Planck_lambda(temp, lambdas.data(), lambdas.size(), B.data());
+	return trapz(lambdas, [&transmissions, &B](const size_t i) -> double {
+		return transmissions[i] * B[i];
+	},
+			0,
+			lambdas.size() - 1);
+}
+
+// d integral / d ln(T), dB / d ln(T) = B x / (1 - exp(-x)), x = hc / lambda k T
+double EnergyPassband::bbIntegralDlogT(const vecd& lambdas, const vecd& transmissions, const double temp) {
+	vecd B(lambdas.size());
+	Spectrum::Planck_lambda(temp, lambdas.data(), lambdas.size(), B.data());
+	return trapz(lambdas, [&lambdas, &transmissions, &B, temp](const size_t i) -> double {
+		const double x = Spectrum::ch_over_kB / (lambdas[i] * temp);
+		return transmissions[i] * B[i] * x / (-std::expm1(-x));
 	},
 			0,
-			data.size() - 1);
+			lambdas.size() - 1);
+}
+
+EnergyPassband::BlackbodyTable EnergyPassband::bbTableFromData(const vecd& lambdas, const vecd& transmissions) {
+	const double log_T_min = std::log(bb_table_T_min);
+	const double log_T_max = std::log(bb_table_T_max);
+	BlackbodyTable table;
+	table.log_T_min = log_T_min;
+	for (size_t n = 64; ; n *= 2) {
+		table.log_T_step = (log_T_max - log_T_min) / n;
+		table.log_I.resize(n + 1);
+		table.dlog_I_dlog_T.resize(n + 1);
+		for (size_t i = 0; i <= n; ++i) {
+			const double temp = std::exp(log_T_min + i * table.log_T_step);
+			const double integral = bbIntegral(lambdas, transmissions, temp);
+			if (!(integral > 0.)) {
+				return {};
+			}
+			table.log_I[i] = std::log(integral);
+			table.dlog_I_dlog_T[i] = bbIntegralDlogT(lambdas, transmissions, temp) / integral;
+		}
+		double error = 0.;
+		for (size_t i = 0; i < n; ++i) {
+			const double log_T = log_T_min + (i + 0.5) * table.log_T_step;
+			const double integral = bbIntegral(lambdas, transmissions, std::exp(log_T));
+			error = std::max(error, std::fabs(std::exp(interpolateBbTable(table, log_T)) / integral - 1.));
+		}
+		if (!(error > bb_table_rtol)) {
+			break;
+		}
+	}
+	return table;
+}
+
+double EnergyPassband::interpolateBbTable(const BlackbodyTable& table, const double log_T) {
+	const double u = (log_T - table.log_T_min) / table.log_T_step;
+	const size_t i = std::min(static_cast<size_t>(u), table.log_I.size() - 2);
+	const double s = u - i;
+	const double h00 = (1. + 2. * s) * m::pow<2>(1. - s);
+	const double h10 = s * m::pow<2>(1. - s);
+	const double h01 = m::pow<2>(s) * (3. - 2. * s);
+	const double h11 = m::pow<2>(s) * (s - 1.);
+	return h00 * table.log_I[i] + h10 * table.log_T_step * table.dlog_I_dlog_T[i]
+			+ h01 * table.log_I[i + 1] + h11 * table.log_T_step * table.dlog_I_dlog_T[i + 1];
+}
+
+double EnergyPassband::bb_integral(const double temp) const {
+	if (bb_table.log_I.empty() || !(temp >= bb_table_T_min && temp <= bb_table_T_max)) {  // catches NaN
+		return bbIntegral(lambdas, transmissions, temp);
+	}
+	return std::exp(interpolateBbTable(bb_table, std::log(temp)));
 }
@@ -1,9 +1,7 @@
 #include "orbit.hpp"
 #include "spectrum.hpp"
 
-#include <boost/numeric/odeint.hpp>
-
-namespace odeint = boost::numeric::odeint;
+#include <iterator>
 
 
 namespace Spectrum {
@@ -23,17 +21,92 @@ double Planck_lambda(const double T, const double lambda) {
 }
 
 
-double Planck_nu1_nu2(const double T, const double nu1, const double nu2, const double tol){
-	auto stepper = odeint::runge_kutta_cash_karp54<double>();
-	double integral = 0.;
-	integrate_adaptive(
-			odeint::make_controlled(0, tol, stepper),
-			[T](const double &y, double &dydx, double x) {
-				dydx = Planck_nu(T, x);
-			},
-			integral, nu1, nu2, 1e-2 * (nu2 - nu1)
-	);
-	return integral;
+void Planck_lambda(const double* const T, const size_t n, const double lambda, double* const out) {
+	const double coef = double_h_c2 / m::pow<5>(lambda);
+	for (size_t i = 0; i < n; ++i) {
+		const double B = coef / (fast_exp(ch_over_kB / (lambda * T[i])) - 1.);
+		out[i] = T[i] > 0. ? B : 0.;  // catches NaN
+	}
+}
+
+
+void Planck_lambda(const double T, const double* const lambdas, const size_t n, double* const out) {
+	for (size_t i = 0; i < n; ++i) {
+		const double B = double_h_c2 / m::pow<5>(lambdas[i]) / (fast_exp(ch_over_kB / (lambdas[i] * T)) - 1.);
+		out[i] = T > 0. ? B : 0.;  // catches NaN
+	}
+}
+
+
+// Integrals of x^3 / (e^x - 1), x = h nu / k T, which is Planck function in dimensionless units.
+// Below x_series_max the Bernoulli series of the integrand is used, above it the series of polylogarithms
+// \int_x^\infty t^3 / (e^t - 1) dt = \sum_k e^{-kx} (x^3/k + 3x^2/k^2 + 6x/k^3 + 6/k^4).
+// Both are truncated at double precision, which makes band integrals exact up to round-off errors
+namespace {
+// B_{2k} / (2k)!, Taylor coefficients of t / (e^t - 1)
+constexpr const double bernoulli_over_factorial[] = {
+		1. / 12.,
+		-1. / 720.,
+		1. / 30240.,
+		-1. / 1209600.,
+		1. / 47900160.,
+		-691. / 1307674368000.,
+		1. / 74724249600.,
+		-3617. / 10670622842880000.,
+		43867. / 5109094217170944000.,
+		-174611. / 802857662698291200000.,
+};
+constexpr const double x_series_max = 1.;
+const double Planck_x_total = m::pow<4>(M_PI) / 15.;
+
+// \int_0^x t^3 / (e^t - 1) dt, x <= x_series_max
+double Planck_x_head(const double x) {
+	const double x2 = m::pow<2>(x);
+	double x2k = 1.;
+	double sum = 1. / 3. - x / 8.;
+	for (size_t k = 1; k <= std::size(bernoulli_over_factorial); ++k) {
+		x2k *= x2;
+		sum += bernoulli_over_factorial[k - 1] * x2k / (2. * k + 3.);
+	}
+	return m::pow<3>(x) * sum;
+}
+
+// \int_x^\infty t^3 / (e^t - 1) dt, x >= x_series_max
+double Planck_x_tail(const double x) {
+	const double q = std::exp(-x);
+	if (!(q > 0.)) {  // catches infinite x
+		return 0.;
+	}
+	double qk = 1.;
+	double sum = 0.;
+	for (double k = 1.; ; k += 1.) {
+		qk *= q;
+		const double term = qk * (m::pow<3>(x) / k + 3. * m::pow<2>(x) / m::pow<2>(k) + 6. * x / m::pow<3>(k) + 6. / m::pow<4>(k));
+		sum += term;
+		if (term <= std::numeric_limits<double>::epsilon() * sum) {
+			break;
+		}
+	}
+	return sum;
+}
+} // namespace
+
+
+double Planck_nu1_nu2(const double T, const double nu1, const double nu2) {
+	if (!(T > 0.)) {  // catches NaN
+		return 0.;
+	}
+	const double x1 = h_over_kB * nu1 / T;
+	const double x2 = h_over_kB * nu2 / T;
+	double integral;
+	if (x2 <= x_series_max) {
+		integral = Planck_x_head(x2) - Planck_x_head(x1);
+	} else if (x1 >= x_series_max) {
+		integral = Planck_x_tail(x1) - Planck_x_tail(x2);
+	} else {
+		integral = Planck_x_total - Planck_x_head(x1) - Planck_x_tail(x2);
+	}
+	return double_h_over_c2 * m::pow<4>(T / h_over_kB) * integral;
 }
 
 
@@ -41,7 +114,7 @@ double Planck_nu1_nu2(const double T, const double nu1, const double nu2, const
 /* General Relativity effects are included in the structure of the disk
    (Page & Thorne 1974; Riffert & Herold 1995). metric = "GR"
 */
-double T_GR(const double r1, const double ak, const double Mx, const double Mdot){
+double Qvis_GR_coef(const double r1, const double ak, const double Mx){
 	const double GM = GSL_CONST_CGSM_GRAVITATIONAL_CONSTANT * Mx;
 	const double rg = GM  / m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT);
 	const double x = std::sqrt(r1 / rg);
@@ -58,12 +131,12 @@ double T_GR(const double r1, const double ak, const double Mx, const double Mdot
 	const double b = 3. * (x2-ak)*(x2-ak) * std::log((x-x2)/(x0-x2))/x2/(x2-x1)/(x2-x3);
 	const double c = 3. * (x3-ak)*(x3-ak) * std::log((x-x3)/(x0-x3))/x3/(x3-x1)/(x3-x2);
 
-	return( std::pow(
-			(3.*Mdot * m::pow<6>(GSL_CONST_CGSM_SPEED_OF_LIGHT) / (8.*M_PI * m::pow<2>(GM))) *
-			(x - x0 - 1.5 * ak * std::log(x/x0) - a - b -c) / ( m::pow<4>(x)*(m::pow<3>(x) - 3.*x + 2. * ak) ) /
-			GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT,
-			0.25)
+	return (3. * m::pow<6>(GSL_CONST_CGSM_SPEED_OF_LIGHT) / (8.*M_PI * m::pow<2>(GM))) *
+			(x - x0 - 1.5 * ak * std::log(x/x0) - a - b -c) / ( m::pow<4>(x)*(m::pow<3>(x) - 3.*x + 2. * ak) );
+}
+
 
-	);
+double T_GR(const double r1, const double ak, const double Mx, const double Mdot){
+	return std::pow(Mdot * Qvis_GR_coef(r1, ak, Mx) / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT, 0.25);
 }
 } // namespace Spectrum
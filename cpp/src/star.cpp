@@ -101,8 +101,11 @@ double Star::luminosity(const UnitVec3& direction) {
 // "luminosity in direction" / (4 \pi d^2)
 
 double Star::luminosity(const UnitVec3& direction, double lambda) {
-	return integrate([this, lambda](size_t i) -> double {
-			return Spectrum::Planck_lambda(Teff()[i], lambda) * m::pow<2>(lambda) / GSL_CONST_CGSM_SPEED_OF_LIGHT;
+	const vald& T = Teff();
+	vald B(T.size());
+	Spectrum::Planck_lambda(&T[0], T.size(), lambda, &B[0]);
+	return integrate([&B, lambda](size_t i) -> double {
+			return B[i] * m::pow<2>(lambda) / GSL_CONST_CGSM_SPEED_OF_LIGHT;
 		},
 			direction) * FOUR_M_PI;
 }
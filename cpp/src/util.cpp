@@ -18,28 +18,11 @@ double trapz(const vecd& x, const vecd& y, const size_t first, const size_t last
 }
 
 
-double trapz(const vecd& x, const std::function<double (size_t)>& f, const size_t first, const size_t last) {
-	if (first >= last) {
-		return 0.;
-	}
-	double s = f(first) * (x[first + 1] - x[first]) + f(last) * (x[last] - x[last - 1]);
-	for (size_t i = first + 1; i <= last - 1; i++) {
-		s += f(i) * (x[i + 1] - x[i - 1]);
-	}
-	return 0.5 * s;
-}
-
-
 double disk_radial_trapz(const vecd& r, const vecd& y, const size_t first, const size_t last) {
 	return trapz(r, [&r, &y](const size_t i) -> double { return 2*M_PI * r[i] * y[i]; }, first, last);
 }
 
 
-double disk_radial_trapz(const vecd& r, const std::function<double (size_t)>& f, const size_t first, const size_t last) {
-	return trapz(r, [&r, f](const size_t i) -> double { return 2*M_PI * r[i] * f(i); }, first, last);
-}
-
-
 double simps(const vecd& x, const vecd& y, const size_t first, const size_t last) {
 	const size_t N = last - first + 1;
 	switch (N) {
@@ -69,30 +52,58 @@ double simps(const vecd& x, const vecd& y, const size_t first, const size_t last
 }
 
 
-double simps(const vecd& x, const std::function<double (size_t)>& f, const size_t first, const size_t last) {
-	const size_t N = last - first + 1;
-	switch (N) {
-		case 0:
-			return 0;
-		case 1:
-			return 0;
-		case 2:
-			return 0.5 * (f(first) + f(last)) * (x[last] - x[first]);
+ThreadPool::ThreadPool(const unsigned int threads) {
+	for (unsigned int i = 1; i < threads; i++) {
+		workers_.emplace_back(&ThreadPool::work, this);
 	}
-	if (N % static_cast<size_t>(2) == static_cast<size_t>(0)) {
-		return simps(x, f, first + 1, last) + simps(x, f, first, first + 1);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
 	}
+	start_.notify_all();
+	for (auto& worker : workers_) {
+		worker.join();
+	}
+}
 
-	double delta = (x[first+2] - x[first]);
-	double s = f(first) * delta * (2. - (x[first+2] - x[first+1]) / (x[first+1] - x[first]))
-			   + f(first+1) * bm::pow<3>(delta) / ((x[first+2] - x[first+1]) * (x[first+1] - x[first]))
-			   + f(last) * (2. - (x[last-1] - x[last]) / (x[last] - x[last] - 1));
-	for (size_t i = first + 2; i <= last - 2; i += 2) {
-		delta = x[i+2] - x[i];
-		s += f(i) * (delta * (2. - (x[i+2] - x[i+1]) / (x[i+1] - x[i]))
-					 + (x[i] - x[i-2]) * (2. - (x[i-1] - x[i-2]) / (x[i] - x[i-1])))
-			 + f(i+1) * bm::pow<3>(delta) / ((x[i+2] - x[i+1]) * (x[i+1] - x[i]));
+void ThreadPool::process(std::unique_lock<std::mutex>& lock) {
+	while (next_task_ < n_tasks_) {
+		const size_t i = next_task_++;
+		lock.unlock();
+		(*task_)(i);
+		lock.lock();
+		if (--pending_ == 0) {
+			finish_.notify_all();
+		}
 	}
-	s /= 6.;
-	return s;
+}
+
+void ThreadPool::work() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	unsigned long generation = generation_;
+	while (true) {
+		start_.wait(lock, [this, generation] { return stop_ || generation_ != generation; });
+		if (stop_) {
+			return;
+		}
+		generation = generation_;
+		process(lock);
+	}
+}
+
+void ThreadPool::run(const size_t n_tasks, const std::function<void (size_t)>& task) {
+	std::lock_guard<std::mutex> run_lock(run_mutex_);
+	std::unique_lock<std::mutex> lock(mutex_);
+	task_ = &task;
+	n_tasks_ = n_tasks;
+	next_task_ = 0;
+	pending_ = n_tasks;
+	++generation_;
+	start_.notify_all();
+	process(lock);
+	finish_.wait(lock, [this] { return pending_ == 0; });
+	task_ = nullptr;
 }
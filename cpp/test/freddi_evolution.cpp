@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <freddi_evolution.hpp>
+#include <options.hpp>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_freddi_evolution
+
+#include <boost/test/unit_test.hpp>
+
+
+namespace po = boost::program_options;
+
+
+// Default options are replaced by the given ones with the same name
+FreddiArguments get_args(const std::vector<std::string>& options) {
+	const std::vector<std::string> default_options = {"--Mx=5", "--Mopt=0.5", "--period=0.25", "--distance=10", "--time=20", "--tau=0.5", "--initialcond=sineF"};
+	std::vector<std::string> all_options;
+	for (const auto& default_option : default_options) {
+		const std::string name = default_option.substr(0, default_option.find('=') + 1);
+		if (std::none_of(options.begin(), options.end(), [&name](const std::string& option) { return option.compare(0, name.size(), name) == 0; })) {
+			all_options.push_back(default_option);
+		}
+	}
+	all_options.insert(all_options.end(), options.begin(), options.end());
+	po::variables_map vm;
+	po::store(po::command_line_parser(all_options).options(FreddiOptions::description()).run(), vm);
+	po::notify(vm);
+	return FreddiOptions(vm);
+}
+
+void check_batch(const std::vector<std::vector<std::string>>& options) {
+	std::vector<FreddiArguments> args;
+	std::vector<std::unique_ptr<FreddiEvolution>> disks;
+	for (const auto& disk_options : options) {
+		args.push_back(get_args(disk_options));
+		disks.emplace_back(new FreddiEvolution(args.back()));
+	}
+	FreddiEvolutionBatch batch(args);
+	BOOST_REQUIRE_EQUAL(batch.size(), disks.size());
+	for (size_t i_t = 0; i_t < disks.front()->Nt(); i_t++) {
+		batch.step();
+		for (size_t l = 0; l < disks.size(); l++) {
+			disks[l]->step();
+			BOOST_CHECK_EQUAL(batch[l].t(), disks[l]->t());
+			BOOST_CHECK_EQUAL(batch[l].last(), disks[l]->last());
+			BOOST_CHECK_EQUAL(batch[l].nonlinear_iterations(), disks[l]->nonlinear_iterations());
+			BOOST_CHECK_EQUAL(batch[l].Mdot_in(), disks[l]->Mdot_in());
+			BOOST_CHECK_EQUAL(batch[l].Mdisk(), disks[l]->Mdisk());
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_lockstep) {
+	check_batch({
+		{"--alpha=0.25", "--F0=2e38"},
+		{"--alpha=0.1", "--F0=1e38"},
+		{"--alpha=0.5", "--F0=5e37", "--opacity=OPAL"},
+		{"--alpha=0.25", "--F0=2e38", "--Cirr=1e-4"},
+	});
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_different_boundaries) {
+	check_batch({
+		{"--alpha=0.25", "--F0=2e38", "--Thot=1e4"},
+		{"--alpha=0.25", "--F0=2e38"},
+	});
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_independent) {
+	check_batch({
+		{"--alpha=0.25", "--F0=2e38", "--timescheme=bdf2"},
+		{"--alpha=0.25", "--F0=2e38", "--nonlinearsolver=newton"},
+	});
+}
+
+double max_Mdot_error(const std::vector<std::string>& options, const std::vector<std::string>& reference_options) {
+	FreddiEvolution freddi(get_args(options));
+	FreddiEvolution reference(get_args(reference_options));
+	double error = 0.;
+	for (size_t i_t = 0; i_t < freddi.Nt(); i_t++) {
+		freddi.step();
+		reference.step();
+		error = std::max(error, std::abs(freddi.Mdot_in() / reference.Mdot_in() - 1.));
+	}
+	return error;
+}
+
+BOOST_AUTO_TEST_CASE(test_remesh_accuracy) {
+	const std::vector<std::string> reference = {"--alpha=0.25", "--F0=2e38", "--Thot=1e4", "--Nx=4000"};
+	std::vector<std::string> uniform = {"--alpha=0.25", "--F0=2e38", "--Thot=1e4", "--Nx=250"};
+	std::vector<std::string> remesh(uniform);
+	remesh.push_back("--remesh");
+	const double uniform_error = max_Mdot_error(uniform, reference);
+	const double remesh_error = max_Mdot_error(remesh, reference);
+	BOOST_CHECK_LT(remesh_error, 0.25 * uniform_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_moving_boundary_grid_independence) {
+	const std::vector<std::string> options = {"--alpha=0.25", "--F0=2e38", "--Thot=1e4", "--Cirr=2e-4", "--Qirr2Qvishot=1", "--remesh", "--movingboundary"};
+	std::vector<std::string> coarse(options), fine(options);
+	coarse.push_back("--Nx=200");
+	fine.push_back("--Nx=800");
+	FreddiEvolution freddi_coarse(get_args(coarse));
+	FreddiEvolution freddi_fine(get_args(fine));
+	for (size_t i_t = 0; i_t < freddi_coarse.Nt(); i_t++) {
+		freddi_coarse.step();
+		freddi_fine.step();
+		BOOST_CHECK_CLOSE(freddi_coarse.R()[freddi_coarse.last()], freddi_fine.R()[freddi_fine.last()], 0.1);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_predictor) {
+	FreddiEvolution freddi(get_args({"--alpha=0.25", "--F0=2e38"}));
+	FreddiEvolution freddi_predictor(get_args({"--alpha=0.25", "--F0=2e38", "--predictor"}));
+	unsigned int iterations = 0, iterations_predictor = 0;
+	for (size_t i_t = 0; i_t < freddi.Nt(); i_t++) {
+		freddi.step();
+		freddi_predictor.step();
+		iterations += freddi.nonlinear_iterations();
+		iterations_predictor += freddi_predictor.nonlinear_iterations();
+		BOOST_CHECK_CLOSE(freddi_predictor.Mdot_in(), freddi.Mdot_in(), 0.05);
+	}
+	BOOST_CHECK_LT(iterations_predictor, iterations);
+}
+
+// Explicit coupling of this wind makes accretion rate negative on the seventh step
+BOOST_AUTO_TEST_CASE(test_implicit_wind_stability) {
+	FreddiEvolution freddi(get_args({"--alpha=0.25", "--F0=2e38", "--initialcond=powerF", "--powerorder=6", "--Thot=1e4", "--Cirr=2e-4", "--windtype=Shields1986", "--windXi_max=10", "--windT_ic=1e8", "--windPow=20", "--windcoupling=implicit"}));
+	for (size_t i_t = 0; i_t < freddi.Nt(); i_t++) {
+		freddi.step();
+		BOOST_CHECK_GT(freddi.Mdot_in(), 0.);
+	}
+}
+
+// Copy of the disk with all optional quantities calculated from scratch
+class FreddiEvolutionFromScratch: public FreddiEvolution {
+public:
+	explicit FreddiEvolutionFromScratch(const FreddiEvolution& freddi): FreddiEvolution(freddi) {
+		invalidate_optional_structure(ChangedAll);
+	}
+};
+
+BOOST_AUTO_TEST_CASE(test_partial_invalidation) {
+	FreddiEvolution freddi(get_args({"--alpha=0.25", "--F0=2e37", "--Thot=1e4", "--Cirr=2e-4", "--Cirrcold=1e-4", "--h2rcold=0.05"}));
+	for (size_t i_t = 0; i_t < freddi.Nt(); i_t++) {
+		freddi.step();
+		// Profiles calculated before the outer boundary moved are recalculated near the boundary only
+		FreddiEvolutionFromScratch scratch(freddi);
+		BOOST_CHECK(freddi.Height() == scratch.Height());
+		BOOST_CHECK(freddi.Tph() == scratch.Tph());
+		BOOST_CHECK(freddi.Tirr() == scratch.Tirr());
+		BOOST_CHECK(freddi.Sigma() == scratch.Sigma());
+		BOOST_CHECK(freddi.Tph_X() == scratch.Tph_X());
+		BOOST_CHECK_EQUAL(freddi.Mdisk(), scratch.Mdisk());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_fluxes) {
+	FreddiEvolution freddi(get_args({"--alpha=0.25", "--F0=2e37", "--Thot=1e4", "--Cirr=2e-4", "--Cirrcold=1e-4", "--h2rcold=0.05", "--colddiskflux", "--lambda=3000", "--lambda=5500", "--lambda=10000"}));
+	const auto& lambdas = freddi.lambdas();
+	for (size_t i_t = 0; i_t < freddi.Nt(); i_t++) {
+		freddi.step();
+		// Fluxes are calculated once per step for all wavelengths together
+		for (size_t i = 0; i < lambdas.size(); i++) {
+			BOOST_CHECK_EQUAL(freddi.fluxes()[i], freddi.flux(lambdas[i]));
+			BOOST_CHECK_EQUAL(freddi.fluxes_region<FreddiState::ColdRegion>()[i], freddi.flux_region<FreddiState::ColdRegion>(lambdas[i]));
+		}
+	}
+}
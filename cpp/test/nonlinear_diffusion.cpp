@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <nonlinear_diffusion.hpp>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_nonlinear_diffusion
+
+#include <boost/test/unit_test.hpp>
+
+
+const double m = 0.3;
+
+void wunc(const vecd& x, const vecd& y, vecd& w, size_t first, size_t last) {
+	for (size_t i = first; i <= last; i++) {
+		w[i] = std::pow(std::abs(y[i]), 1. - m) * x[i];
+	}
+}
+
+void dwunc(const vecd& x, const vecd& y, const vecd& w, vecd& dw, size_t first, size_t last) {
+	for (size_t i = first; i <= last; i++) {
+		dw[i] = (1. - m) * w[i] / y[i];
+	}
+}
+
+vecd get_x(size_t N) {
+	vecd x(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = 1. + std::pow(i / (N - 1.), 2);
+	}
+	return x;
+}
+
+vecd get_y(const vecd& x) {
+	vecd y(x.size());
+	for (size_t i = 0; i < x.size(); i++) {
+		y[i] = std::sin(M_PI / 2 * (x[i] - x.front()));
+	}
+	return y;
+}
+
+vecd evolve(NonlinearDiffusionSolver::Method method, double tau, size_t Nt, unsigned int* iterations = nullptr, bool bdf2 = false) {
+	const size_t N = 101;
+	const auto x = get_x(N);
+	auto y = get_y(x);
+	auto y_prev = y;
+	const vecd zeros(N, 0.);
+	NonlinearDiffusionSolver solver(N, method, 3);
+	if (iterations) {
+		*iterations = 0;
+	}
+	for (size_t i_t = 0; i_t < Nt; i_t++) {
+		const auto y_0 = y;
+		solver(tau, 1e-10, 0., 1., zeros, zeros, zeros, wunc, dwunc, x, y, 0, N - 1, (bdf2 && i_t > 0) ? tau : 0., y_prev);
+		y_prev = y_0;
+		BOOST_CHECK_LE(solver.residual(), 1e-10);
+		if (iterations) {
+			*iterations += solver.iterations();
+		}
+	}
+	return y;
+}
+
+BOOST_AUTO_TEST_CASE(test_newton_equals_picard) {
+	const auto picard = evolve(NonlinearDiffusionSolver::Picard, 0.01, 10);
+	const auto newton = evolve(NonlinearDiffusionSolver::Newton, 0.01, 10);
+	for (size_t i = 1; i < picard.size(); i++) {
+		BOOST_CHECK_CLOSE_FRACTION(newton[i], picard[i], 1e-8);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_anderson_equals_picard) {
+	unsigned int picard_iterations, anderson_iterations;
+	const auto picard = evolve(NonlinearDiffusionSolver::Picard, 0.01, 10, &picard_iterations);
+	const auto anderson = evolve(NonlinearDiffusionSolver::Anderson, 0.01, 10, &anderson_iterations);
+	for (size_t i = 1; i < picard.size(); i++) {
+		BOOST_CHECK_CLOSE_FRACTION(anderson[i], picard[i], 1e-8);
+	}
+	BOOST_CHECK_LT(anderson_iterations, picard_iterations);
+}
+
+BOOST_AUTO_TEST_CASE(test_stationary) {
+	const auto x = get_x(101);
+	for (auto method : {NonlinearDiffusionSolver::Picard, NonlinearDiffusionSolver::Newton, NonlinearDiffusionSolver::Anderson}) {
+		const auto y = evolve(method, 100., 100);
+		for (size_t i = 1; i < y.size(); i++) {
+			BOOST_CHECK_CLOSE_FRACTION(y[i], x[i] - x.front(), 1e-6);
+		}
+	}
+}
+
+double max_error(const vecd& y, const vecd& y_ref) {
+	double error = 0.;
+	for (size_t i = 1; i < y.size(); i++) {
+		error = std::max(error, std::abs(y[i] / y_ref[i] - 1.));
+	}
+	return error;
+}
+
+BOOST_AUTO_TEST_CASE(test_bdf2_order) {
+	const double time = 0.1;
+	const auto reference = evolve(NonlinearDiffusionSolver::Picard, time / 1000, 1000, nullptr, true);
+	const double euler_error = max_error(evolve(NonlinearDiffusionSolver::Picard, time / 10, 10), reference);
+	const double euler_error_half = max_error(evolve(NonlinearDiffusionSolver::Picard, time / 20, 20), reference);
+	const double bdf2_error = max_error(evolve(NonlinearDiffusionSolver::Picard, time / 10, 10, nullptr, true), reference);
+	const double bdf2_error_half = max_error(evolve(NonlinearDiffusionSolver::Picard, time / 20, 20, nullptr, true), reference);
+	BOOST_CHECK_LT(bdf2_error, euler_error);
+	BOOST_CHECK_CLOSE_FRACTION(euler_error / euler_error_half, 2., 0.2);
+	BOOST_CHECK_CLOSE_FRACTION(bdf2_error / bdf2_error_half, 4., 0.2);
+}
+
+BOOST_AUTO_TEST_CASE(test_invalidate_coefficients) {
+	const size_t N = 101;
+	const auto x = get_x(N);
+	const vecd zeros(N, 0.);
+	vecd B(N, 0.);
+	NonlinearDiffusionSolver solver(N);
+	auto y = get_y(x);
+	solver(0.01, 1e-10, 0., 1., zeros, B, zeros, wunc, dwunc, x, y, 0, N - 1);
+	auto y_fresh = y;
+	B.assign(N, -1.);
+	solver.invalidate_coefficients();
+	solver(0.01, 1e-10, 0., 1., zeros, B, zeros, wunc, dwunc, x, y, 0, N - 1);
+	NonlinearDiffusionSolver fresh_solver(N);
+	fresh_solver(0.01, 1e-10, 0., 1., zeros, B, zeros, wunc, dwunc, x, y_fresh, 0, N - 1);
+	for (size_t i = 0; i < N; i++) {
+		BOOST_CHECK_EQUAL(y[i], y_fresh[i]);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_initial_guess) {
+	const size_t N = 101;
+	const auto x = get_x(N);
+	const vecd zeros(N, 0.);
+	for (auto method : {NonlinearDiffusionSolver::Picard, NonlinearDiffusionSolver::Newton, NonlinearDiffusionSolver::Anderson}) {
+		NonlinearDiffusionSolver solver(N, method, 3);
+		const auto y_0 = get_y(x);
+		auto y = y_0;
+		solver(0.01, 1e-10, 0., 1., zeros, zeros, zeros, wunc, dwunc, x, y, 0, N - 1);
+		const unsigned int iterations = solver.iterations();
+		auto y_guessed = y_0;
+		solver(0.01, 1e-10, 0., 1., zeros, zeros, zeros, wunc, dwunc, x, y_guessed, 0, N - 1, 0., vecd(), y);
+		for (size_t i = 1; i < N; i++) {
+			BOOST_CHECK_CLOSE_FRACTION(y_guessed[i], y[i], 1e-8);
+		}
+		BOOST_CHECK_LT(solver.iterations(), iterations);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_partitioned_equals_serial) {
+	const size_t N = 1001;
+	const auto x = get_x(N);
+	const vecd zeros(N, 0.);
+	for (unsigned int threads : {2u, 3u, 4u, 7u}) {
+		NonlinearDiffusionSolver serial(N, NonlinearDiffusionSolver::Picard, 0, 1);
+		NonlinearDiffusionSolver partitioned(N, NonlinearDiffusionSolver::Picard, 0, threads, 0);
+		auto y_serial = get_y(x);
+		auto y_partitioned = y_serial;
+		for (size_t i_t = 0; i_t < 10; i_t++) {
+			serial(0.01, 1e-10, 0., 1., zeros, zeros, zeros, wunc, dwunc, x, y_serial, 0, N - 1);
+			partitioned(0.01, 1e-10, 0., 1., zeros, zeros, zeros, wunc, dwunc, x, y_partitioned, 0, N - 1);
+		}
+		for (size_t i = 1; i < N; i++) {
+			BOOST_CHECK_CLOSE_FRACTION(y_partitioned[i], y_serial[i], 1e-10);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_equals_single) {
+	const size_t N = 101;
+	const size_t L = 3;
+	const vecd tau = {0.01, 0.1, 1.};
+	const vecd eps = {1e-10, 1e-8, 1e-10};
+	const vecd left = {0., 0.1, 0.};
+	const vecd right = {1., 2., 0.5};
+	const vecd zeros(N, 0.);
+	const vecd batch_zeros(N * L, 0.);
+	std::vector<vecd> x(L), y(L);
+	vecd batch_x(N * L), batch_y(N * L);
+	for (size_t l = 0; l < L; l++) {
+		x[l] = get_x(N);
+		for (auto& value : x[l]) {
+			value *= 1. + l;
+		}
+		y[l] = get_y(x[l]);
+		for (size_t i = 0; i < N; i++) {
+			batch_x[i * L + l] = x[l][i];
+			batch_y[i * L + l] = y[l][i];
+		}
+	}
+	BatchNonlinearDiffusionSolver batch_solver(L, N);
+	for (size_t i_t = 0; i_t < 10; i_t++) {
+		batch_solver(tau, eps, left, right, batch_zeros, batch_zeros, batch_zeros,
+				[](const vecd& x, const vecd& y, vecd& w, size_t first, size_t last) {
+					wunc(x, y, w, first * L, last * L + L - 1);
+				},
+				batch_x, batch_y, 0, N - 1);
+		for (size_t l = 0; l < L; l++) {
+			NonlinearDiffusionSolver solver(N);
+			solver(tau[l], eps[l], left[l], right[l], zeros, zeros, zeros, wunc, dwunc, x[l], y[l], 0, N - 1);
+			BOOST_CHECK_EQUAL(batch_solver.iterations()[l], solver.iterations());
+			BOOST_CHECK_EQUAL(batch_solver.residual()[l], solver.residual());
+			for (size_t i = 0; i < N; i++) {
+				BOOST_CHECK_EQUAL(batch_y[i * L + l], y[l][i]);
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#include <cmath>
+#include <vector>
+
+#include <passband.hpp>
+#include <spectrum.hpp>
+#include <unit_transformation.hpp>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_passband
+
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+
+
+EnergyPassband get_passband() {
+	std::vector<EnergyPassband::PassbandPoint> data;
+	for (double lambda = 4500.; lambda <= 6500.; lambda += 20.) {
+		data.emplace_back(angstromToCm(lambda), std::exp(-m::pow<2>((lambda - 5500.) / 400.)));
+	}
+	return EnergyPassband("test", data);
+}
+
+double bb_lambda_direct(const EnergyPassband& passband, double temp) {
+	const double integral = trapz(passband.lambdas, [&passband, temp](const size_t i) -> double {
+		return passband.transmissions[i] * Spectrum::Planck_lambda(temp, passband.lambdas[i]);
+	}, 0, passband.data.size() - 1);
+	return integral / passband.t_dl;
+}
+
+
+BOOST_AUTO_TEST_CASE(test_bb_table) {
+	const auto passband = get_passband();
+	for (double temp = 500.; temp < 3e8; temp *= 1.037) {
+		BOOST_CHECK_CLOSE_FRACTION(passband.bb_lambda(temp), bb_lambda_direct(passband, temp), 1e-7);
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(test_bb_table_zero_temperature) {
+	const auto passband = get_passband();
+	BOOST_CHECK_EQUAL(passband.bb_lambda(0.), 0.);
+	BOOST_CHECK_EQUAL(passband.bb_lambda(std::nan("")), 0.);
+}
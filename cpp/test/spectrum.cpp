@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <boost/numeric/odeint.hpp>
+
+#include <orbit.hpp>
+#include <spectrum.hpp>
+#include <unit_transformation.hpp>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_spectrum
+
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace odeint = boost::numeric::odeint;
+
+
+BOOST_AUTO_TEST_CASE(test_Planck_nu1_nu2_total) {
+	const double T = 1e4;
+	const double integral = Spectrum::Planck_nu1_nu2(T, 0., std::numeric_limits<double>::infinity());
+	BOOST_CHECK_CLOSE_FRACTION(integral, GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT * m::pow<4>(T) / M_PI, 1e-10);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_Planck_nu1_nu2_odeint) {
+	const std::vector<double> T_ = {1e3, 1e5, 3e6, 1e7, 1e8, 1e10};
+	const std::vector<double> e1_ = {0.01, 1., 1.};
+	const std::vector<double> e2_ = {0.1, 12., 100.};
+	const double tol = 1e-10;
+
+	auto stepper = odeint::runge_kutta_cash_karp54<double>();
+
+	for (double T : T_) {
+		for (size_t i = 0; i < e1_.size(); ++i) {
+			const double nu1 = kevToHertz(e1_[i]);
+			const double nu2 = kevToHertz(e2_[i]);
+
+			double integral = 0.;
+			integrate_adaptive(
+					odeint::make_controlled(0, tol, stepper),
+					[T](const double &y, double &dydx, double x) {
+						dydx = Spectrum::Planck_nu(T, x);
+					},
+					integral, nu1, nu2, 1e-2 * (nu2 - nu1)
+			);
+			BOOST_CHECK_CLOSE_FRACTION(Spectrum::Planck_nu1_nu2(T, nu1, nu2), integral, 1e-8);
+		}
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(test_Planck_nu1_nu2_zero_temperature) {
+	BOOST_CHECK_EQUAL(Spectrum::Planck_nu1_nu2(0., 1e15, 1e16), 0.);
+	BOOST_CHECK_EQUAL(Spectrum::Planck_nu1_nu2(std::nan(""), 1e15, 1e16), 0.);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_Qvis_GR_coef_newtonian_limit) {
+	const double Mx = sunToGram(10.);
+	const double GM = GSL_CONST_CGSM_GRAVITATIONAL_CONSTANT * Mx;
+	const double rg = GM / m::pow<2>(GSL_CONST_CGSM_SPEED_OF_LIGHT);
+	for (double ak : {0., 0.9}) {
+		const double r = 1e6 * rg;
+		const double Qvis_newtonian = 3. * GM / (8. * M_PI * m::pow<3>(r)) * (1. - std::sqrt(r_kerrISCORg(ak) * rg / r));
+		BOOST_CHECK_CLOSE_FRACTION(Spectrum::Qvis_GR_coef(r, ak, Mx), Qvis_newtonian, 1e-2);
+		BOOST_CHECK_EQUAL(Spectrum::Qvis_GR_coef(0.5 * r_kerrISCORg(ak) * rg, ak, Mx), 0.);
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(test_fast_exp) {
+	double max_error = 0.;
+	for (double x = -707.9; x < 709.7; x += 0.0137) {
+		max_error = std::max(max_error, std::fabs(Spectrum::fast_exp(x) / std::exp(x) - 1.));
+	}
+	BOOST_CHECK_LE(max_error, 2. * std::numeric_limits<double>::epsilon());
+	BOOST_CHECK_EQUAL(Spectrum::fast_exp(0.), 1.);
+	BOOST_CHECK_EQUAL(Spectrum::fast_exp(1e3), std::numeric_limits<double>::infinity());
+	BOOST_CHECK_EQUAL(Spectrum::fast_exp(-1e3), 0.);
+	BOOST_CHECK(std::isnan(Spectrum::fast_exp(std::nan(""))));
+}
+
+
+BOOST_AUTO_TEST_CASE(test_Planck_lambda_array) {
+	const double lambda = angstromToCm(5500.);
+	const std::vector<double> T = {0., -1e4, std::nan(""), 1e2, 1e3, 1e4, 1e6};
+	std::vector<double> B(T.size());
+	Spectrum::Planck_lambda(T.data(), T.size(), lambda, B.data());
+	for (size_t i = 0; i < T.size(); ++i) {
+		BOOST_CHECK_CLOSE_FRACTION(B[i], Spectrum::Planck_lambda(T[i], lambda), 1e-14);
+	}
+
+	const std::vector<double> lambdas = {angstromToCm(1000.), angstromToCm(5500.), angstromToCm(1e5)};
+	B.resize(lambdas.size());
+	Spectrum::Planck_lambda(1e4, lambdas.data(), lambdas.size(), B.data());
+	for (size_t i = 0; i < lambdas.size(); ++i) {
+		BOOST_CHECK_CLOSE_FRACTION(B[i], Spectrum::Planck_lambda(1e4, lambdas[i]), 1e-14);
+	}
+}
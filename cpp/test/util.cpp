@@ -40,6 +40,16 @@ BOOST_AUTO_TEST_CASE(test_trapz) {
 	BOOST_CHECK_CLOSE_FRACTION(result, 1.9829331321624648, 1e-12);
 }
 
+BOOST_AUTO_TEST_CASE(test_trapz_callable) {
+	const size_t N = 11;
+	const auto x = get_x(N);
+	const auto y = get_y(x);
+	const auto f = [&x](const size_t i) -> double { return std::sin(x[i]); };
+
+	BOOST_CHECK_EQUAL(trapz(x, f, 0, N-1), trapz(x, y, 0, N-1));
+	BOOST_CHECK_EQUAL(disk_radial_trapz(x, f, 0, N-1), disk_radial_trapz(x, y, 0, N-1));
+}
+
 BOOST_AUTO_TEST_CASE(test_simps_odd) {
 	const size_t N = 11;
 	const auto x = get_x(N);
@@ -70,3 +80,13 @@ BOOST_AUTO_TEST_CASE(test_simps_even) {
 	// scipy.integrate.simps(even='right')
 	BOOST_CHECK_CLOSE_FRACTION(result, 1.9999976227091623, 1e-12);
 }
+
+BOOST_AUTO_TEST_CASE(test_simps_callable) {
+	for (size_t N : {11, 12}) {
+		const auto x = get_x(N);
+		const auto y = get_y(x);
+		const auto f = [&x](const size_t i) -> double { return std::sin(x[i]); };
+
+		BOOST_CHECK_EQUAL(simps(x, f, 0, N-1), simps(x, y, 0, N-1));
+	}
+}
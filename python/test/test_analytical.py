@@ -9,7 +9,8 @@ from test_util import DAY, freddi_w_default
 
 
 class ShakuraSunyaevSubctriticalTestCase(unittest.TestCase):
-    def test(self):
+    @parameterized.expand([[b'picard'], [b'newton']])
+    def test(self, nonlinearsolver):
         r"""Shakura-Sunyaev 1973 stationary subcritical disk
 
         The analytical stationary solution is $F ~ (h - h_{in})$
@@ -19,7 +20,8 @@ class ShakuraSunyaevSubctriticalTestCase(unittest.TestCase):
 
         """
         Mdot = 1e18
-        fr = freddi_w_default(initialcond=b'sineF', Mdot0=Mdot/2, Mdotout=Mdot, time=1000*DAY, tau=1*DAY)
+        fr = freddi_w_default(initialcond=b'sineF', Mdot0=Mdot/2, Mdotout=Mdot, time=1000*DAY, tau=1*DAY,
+                              nonlinearsolver=nonlinearsolver)
         for state in fr:
             pass
         h = state.h
@@ -42,3 +42,48 @@ class TwoDimensionalValueTestCase(unittest.TestCase):
                 val = getattr(evolution_result, attr)
                 self.assertTrue(np.all(np.isnan(val[nan_idx])))
                 self.assertFalse(np.any(np.isnan(val[~nan_idx])))
+
+
+class NonlinearSolverTestCase(unittest.TestCase):
+    def test_stats(self):
+        kwargs = dict(Mx=1e34, Mopt=1e33, period=2e4, F0=2e38, initialcond='sineF', alpha=0.25,
+                      distance=1e19, time=50 * 86400, eps=1e-8)
+        results = {solver: Freddi(nonlinearsolver=solver, **kwargs).evolve()
+                   for solver in ('picard', 'anderson')}
+        for solver, result in results.items():
+            with self.subTest(solver):
+                self.assertTrue(np.all(result.nonlinear_iterations[1:] >= 1))
+                self.assertTrue(np.all(result.nonlinear_residual <= 1e-8))
+        self.assertLess(results['anderson'].nonlinear_iterations.sum(), results['picard'].nonlinear_iterations.sum())
+        np.testing.assert_allclose(results['anderson'].F, results['picard'].F, rtol=1e-5)
+
+
+class AdaptiveTauTestCase(unittest.TestCase):
+    def test_adaptive_tau(self):
+        kwargs = dict(Mx=1e34, Mopt=1e33, period=2e4, F0=2e38, initialcond='sineF', alpha=0.25,
+                      distance=1e19, time=50 * 86400, tau=86400)
+        reference = Freddi(**dict(kwargs, tau=0.01 * 86400)).evolve()
+        fixed = Freddi(**kwargs).evolve()
+        adaptive = Freddi(adaptivetau=True, taurtol=1e-3, **kwargs).evolve()
+        np.testing.assert_allclose(adaptive.t, fixed.t)
+        self.assertTrue(np.all(adaptive.tau[1:] <= 86400))
+        self.assertTrue(np.all(adaptive.substeps[1:] >= 1))
+        self.assertGreater(adaptive.substeps.sum(), fixed.substeps.sum())
+        reference_Mdot = reference.Mdot[::100]
+        adaptive_error = np.max(np.abs(adaptive.Mdot / reference_Mdot - 1))
+        fixed_error = np.max(np.abs(fixed.Mdot / reference_Mdot - 1))
+        self.assertLess(adaptive_error, fixed_error)
+
+
+class TimeSchemeTestCase(unittest.TestCase):
+    def test_bdf2(self):
+        kwargs = dict(Mx=1e34, Mopt=1e33, period=2e4, F0=2e38, initialcond='sineF', alpha=0.25,
+                      distance=1e19, time=50 * 86400)
+        reference = Freddi(tau=0.01 * 86400, timescheme='bdf2', **kwargs).evolve()
+        reference_Mdot = reference.Mdot[::100]
+        euler = Freddi(tau=86400, **kwargs).evolve()
+        bdf2 = Freddi(tau=86400, timescheme='bdf2', **kwargs).evolve()
+        # The first step is always made by backward Euler scheme, skip time while its error decays
+        euler_error = np.max(np.abs(euler.Mdot[5:] / reference_Mdot[5:] - 1))
+        bdf2_error = np.max(np.abs(bdf2.Mdot[5:] / reference_Mdot[5:] - 1))
+        self.assertLess(bdf2_error, 0.25 * euler_error)